@@ -0,0 +1,35 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f autoscale.log
+socket=/tmp/taskmaster_autoscale_test.sock
+echo 12 > /tmp/taskmaster_autoscale_depth
+
+replicas() {
+    ./taskmasterctl --socket $socket status --tsv --fields name --where state=READY $1 | tail -n +2 | wc -l
+}
+
+(sleep 8) | ./taskmaster --log-file autoscale.log --config-file ./test/autoscale.yaml --socket $socket >/dev/null 2>&1 &
+sleep 0.5
+
+./taskmasterctl --socket $socket push-metric as-push 35 >/dev/null
+./taskmasterctl --socket $socket push-metric as-cooldown 100 >/dev/null
+sleep 1
+check $(replicas as-push) 4 "pushed metric scales up"
+grep -q "as-push: autoscale 1 -> 3 replica(s)" autoscale.log && grep -q "as-push: autoscale 3 -> 4 replica(s)" autoscale.log
+check $? 0 "by autoscale_step"
+check $(replicas as-command) 3 "command metric"
+[ $(replicas as-cpu) -ge 2 ]
+check $? 0 "cpu metric"
+check $(replicas as-cooldown) 2 "no change during the cooldown"
+./taskmasterctl --socket $socket push-metric as-push 0 >/dev/null
+sleep 1
+check $(replicas as-push) 1 "scales down to autoscale_min"
+grep -q "as-slow: autoscale_command: timed out after 1s" autoscale.log && [ $(replicas as-slow) = 1 ]
+check $? 0 "a slow autoscale_command is killed"
+./taskmasterctl --socket $socket push-metric as-command 1 | grep -q "no such program with autoscale_metric push"
+check $? 0 "push-metric needs autoscale_metric push"
+grep -q "as-bad: autoscale_max: must be at least autoscale_min" autoscale.log
+check $? 0 "autoscale bounds are checked"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
+rm -f /tmp/taskmaster_autoscale_depth
@@ -0,0 +1,123 @@
+/*
+** microbenchmarks of the command parser: time per line and heap allocations
+** per line, once the parser is warm. build and run with `make bench`.
+**
+** only CommandParser::parse is measured, not the dispatch which follows it:
+** Supervisor::executeCommand still allocates, for the ProcessList of targets
+** and in resolveTargets (the set of seen processes, a string per argument,
+** the sorted names for "all" and globs). the numbers below are a floor for
+** a whole command, not its cost.
+*/
+#include "../src/CommandParser.hpp"
+#include "../src/Utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <unordered_map>
+
+static std::atomic<size_t> allocations(0);
+
+void * operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept
+{
+    (void)size;
+    std::free(p);
+}
+
+namespace {
+
+const size_t Iterations = 1000000;
+
+static auto Report(const string & name, double seconds, size_t n_allocations) -> void
+{
+    std::cout << std::left << std::setw(44) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+              << seconds * 1e9 / Iterations << " ns/line"
+              << std::setw(10) << std::setprecision(2)
+              << (double)n_allocations / Iterations << " allocs/line\n";
+}
+
+template <typename F>
+static auto Bench(const string & name, F f) -> void
+{
+    // warm up: buffers reach their final capacity
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        f();
+    }
+    size_t before = allocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; ++i)
+    {
+        f();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    Report(name, seconds, allocations.load() - before);
+}
+
+};
+
+int main()
+{
+    CommandParser parser;
+    string error;
+    const string lines[] = {
+        "status",
+        "restart web_1 web_2 worker_*",
+        "status --json --fields name,state,pid 'web *' \"db\\\"1\"",
+    };
+
+    for (auto name : {"help", "reload", "exit", "history", "list", "validate"})
+    {
+        parser.add({.name = name});
+    }
+    for (auto name : {"start", "stop", "restart"})
+    {
+        parser.add({.name = name, .targets = TargetsRequired});
+    }
+    parser.add({.name = "status", .targets = TargetsDefaultAll,
+        .options = {{"--json"}, {"--tsv"}, {"--fields", true}, {"--where", true}}});
+
+    std::cout << "parse only, target resolution and dispatch not included\n";
+    for (auto & line : lines)
+    {
+        Bench("parse: " + line.substr(0, 36), [&] {
+            if (parser.parse(line, error) != 0)
+            {
+                std::abort();
+            }
+        });
+    }
+
+    // what executeCommand did before: split on spaces, then a map lookup
+    std::unordered_map<string, int> commands = {{"status", 0}, {"restart", 1}, {"help", 2}};
+    for (auto & line : lines)
+    {
+        Bench("split + map: " + line.substr(0, 30), [&] {
+            auto words = Utils::SplitString(line, " ");
+            if (commands.find(words.front()) == commands.end())
+            {
+                std::abort();
+            }
+        });
+    }
+    return 0;
+}
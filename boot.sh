@@ -0,0 +1,37 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f boot.log
+socket=/tmp/taskmaster_boot_test.sock
+
+# seconds of a "<what> at <n>s" in the report
+at() {
+    grep -E "$1" <<< "$report" | grep -oE "$2 at [0-9.]+s" | grep -oE "[0-9.]+"
+}
+
+(sleep 10) | ./taskmaster --log-file boot.log --config-file ./test/boot.yaml --socket $socket >/dev/null 2>&1 &
+sleep 0.3
+./taskmasterctl --socket $socket boot-report | grep -q "^booting$"
+check $? 0 "boot in progress"
+sleep 6.5
+report=$(./taskmasterctl --socket $socket boot-report)
+
+db_ready=$(at "^  boot-db:" ready)
+web_class=$(at "^priority 10:" started)
+awk "BEGIN { exit !($db_ready >= 0.5 && $web_class >= $db_ready) }"
+check $? 0 "a class starts once the previous one is ready"
+web1=$(at "^  boot-web-1:" launched)
+web3=$(at "^  boot-web-3:" launched)
+awk "BEGIN { d = $web3 - $web1; exit !(d > 0.6 && d < 0.9) }"
+check $? 0 "launches spread across start_delay"
+grep -A5 "^priority 10:" <<< "$report" | grep -q "^  boot-dependent: launched"
+check $? 0 "started in the class of its dependency"
+grep -q "^priority 20: .*(window expired)$" <<< "$report" && [ -n "$(at "^  boot-last:" launched)" ]
+check $? 0 "the next class starts once the window expired"
+grep -q "^  boot-never: launched at [0-9.]*s, failed at [0-9.]*s, not ready after 1.5s$" <<< "$report" && [ -n "$(at "^  boot-after:" launched)" ]
+check $? 0 "boot goes on without a program which never gets ready"
+grep -q "^booted 9 program(s) in [0-9.]*s$" <<< "$report"
+check $? 0 "boot report"
+grep -q "boot-bad: start_delay: must be positive" boot.log
+check $? 0 "start_delay is checked"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
@@ -0,0 +1,62 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f confd.log confd_reload.log
+
+(sleep 1; echo exit) | ./taskmaster --log-file confd.log --config-dir ./test/conf.d 2>/dev/null
+
+# expected results
+confd_test_results=(
+    "SUCCESS: confd-ls"
+    "SUCCESS: confd-cat"
+    "SUCCESS: confd-included-echo"
+    "ERROR: confd-ls: duplicate program name"
+)
+
+# log
+file="confd.log"
+
+# Iterate through array of strings
+for i in "${confd_test_results[@]}"
+do
+    # Check if current string is present in file
+    if grep -q "$i" $file; then
+        substring=$(echo $i | cut -d ':' -f2)
+        echo -e "\033[32m PASS: $substring \033[0m"
+    else
+        echo -e "\033[31m FAIL: $i in $file \033[0m"
+    fi
+done
+
+# a deleted fragment: its programs are stopped and removed on reload
+dir=$(mktemp -d)
+socket=/tmp/taskmaster_confd_test.sock
+cp -r ./test/conf.d/. $dir
+cat > $dir/30-sleep.yaml <<EOF
+supervisor-processes:
+  sleep:
+    name: "confd-sleep"
+    full_path: "/bin/sleep"
+    start_command: ["30"]
+    expected_return: 0
+    exec_on_startup: true
+EOF
+(sleep 4) | ./taskmaster --log-file confd_reload.log --config-dir $dir --socket $socket >/dev/null 2>&1 &
+sleep 1
+pid=$(./taskmasterctl --socket $socket status --tsv --fields pid confd-sleep)
+rm $dir/30-sleep.yaml
+./taskmasterctl --socket $socket reload >/dev/null
+./taskmasterctl --socket $socket list | grep -q "confd-sleep"
+check $? 1 "deleted fragment removed on reload"
+[ -n "$pid" ] && ! kill -0 $pid 2>/dev/null
+check $? 0 "removed program stopped"
+./taskmasterctl --socket $socket list | grep -q "confd-cat"
+check $? 0 "other fragments kept"
+echo "supervisor-processes: [" > $dir/40-broken.yaml
+./taskmaster --check --config-dir $dir | grep -q "40-broken.yaml\] file: "
+check $? 0 "--check reports an unparsable fragment"
+./taskmaster --check --config-dir ./test/conf.d | grep -q "\[confd-ls\] name: duplicate program name"
+check $? 0 "--check reports a duplicate name"
+./taskmaster --check --config-dir ./test/conf.d >/dev/null
+check $? 1 "--check fails on config errors"
+wait
+rm -rf $dir confd_reload.log
@@ -0,0 +1,43 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f control.log control_events.log
+socket=/tmp/taskmaster_control_test.sock
+metrics=/tmp/taskmaster_metrics_test.sock
+
+(sleep 5) | ./taskmaster --log-file control.log --config-dir ./test/conf.d --socket $socket --status-shm /taskmaster_control_test --metrics $metrics >/dev/null 2>&1 &
+sleep 1
+
+./taskmasterctl --socket $socket list | grep -q "confd-ls"
+check $? 0 "list over socket"
+./taskmasterctl --socket $socket list confd- | tail -n +2 | sort -c && ./taskmasterctl --socket $socket list confd-c | tail -n +2 | grep -qx "confd-cat"
+check $? 0 "sorted list with a prefix"
+./taskmasterctl --socket $socket not-a-command >/dev/null
+check $? 1 "unknown command status"
+printf 'status confd-ls\nlist\n' | ./taskmasterctl --socket $socket | grep -q "full_path"
+check $? 0 "commands from stdin"
+./taskmasterctl --socket $socket status 'confd-*' | grep -c "^\[" | grep -q 3
+check $? 0 "glob targets"
+./taskmasterctl --socket $socket stop confd-ls not-a-program >/dev/null
+check $? 1 "unknown target status"
+./taskmasterctl --socket $socket status "'confd-l*'" | grep -c "^\[" | grep -q 1
+check $? 0 "quoted targets"
+./taskmasterctl --socket $socket status --not-an-option | grep -q "unknown option"
+check $? 0 "unknown option"
+./taskmasterctl --socket $socket status --json --fields name,state --where 'name=confd-l*' | grep -qx '{"name":"confd-ls","state":"[A-Z]*"}'
+check $? 0 "status as json, filtered"
+./taskmasterctl --status-shm /taskmaster_control_test | grep -q "^confd-ls "
+check $? 0 "status table in shared memory"
+./taskmasterctl --socket $socket subscribe confd-ls --events RUNNING,exit > control_events.log &
+sleep 0.2
+./taskmasterctl --socket $socket restart confd-ls >/dev/null
+sleep 0.5
+grep -q "confd-ls confd-ls exit code 0" control_events.log && ! grep -q "confd-cat" control_events.log
+check $? 0 "event subscription"
+./taskmasterctl --socket $socket --bench 20 50 status >/dev/null
+check $? 0 "concurrent clients"
+curl -s --unix-socket $metrics http://localhost/metrics | grep -q "^taskmaster_spawns_total [1-9]"
+check $? 0 "metrics endpoint"
+./taskmasterctl --socket $socket exit
+sleep 1
+test -e $socket
+check $? 1 "exit removes the socket"
@@ -0,0 +1,27 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f daemon.log daemon_batch.txt
+socket=/tmp/taskmaster_daemon_test.sock
+pidfile=/tmp/taskmaster_daemon_test.pid
+
+printf '# provisioning\nstop confd-ls\n\nstart confd-ls\nnot-a-command\n' > daemon_batch.txt
+./taskmaster --log-file daemon.log --config-dir ./test/conf.d --daemon --socket $socket --pidfile $pidfile --batch daemon_batch.txt >/dev/null 2>&1
+check $? 0 "daemon started"
+pid=$(cat $pidfile)
+ps -o tty= -p $pid | grep -q "?"
+check $? 0 "daemon has no terminal"
+grep -q "3 commands, 1 failed" daemon.log
+check $? 0 "batch commands"
+./taskmaster --log-file daemon.log --config-dir ./test/conf.d --daemon --pidfile $pidfile >/dev/null 2>&1
+check $? 1 "pidfile is locked"
+./taskmasterctl --socket $socket status confd-ls | grep -q "state:"
+check $? 0 "control socket"
+kill -TERM $pid
+sleep 1
+test -e $pidfile || test -e $socket
+check $? 1 "SIGTERM stops the daemon"
+
+printf 'status confd-ls\nexit\n' > daemon_batch.txt
+./taskmaster --log-file daemon.log --config-dir ./test/conf.d --foreground --batch daemon_batch.txt </dev/null >/dev/null 2>&1
+check $? 0 "foreground batch exits"
+rm -f daemon_batch.txt
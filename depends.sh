@@ -0,0 +1,24 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f depends.log
+socket=/tmp/taskmaster_depends_test.sock
+
+(sleep 4) | ./taskmaster --log-file depends.log --config-file ./test/depends.yaml --socket $socket >/dev/null 2>&1 &
+sleep 3
+
+grep -q "dependency cycle among dep-cycle-a, dep-cycle-b" depends.log && grep -q "unknown program dep-nope" depends.log
+check $? 0 "cycles and unknown dependencies are reported"
+grep -q "Started 8 program(s) in 2" depends.log
+check $? 0 "dependencies start first"
+./taskmasterctl --socket $socket status --tsv --fields state,ready_latency dep-db | tail -n 1 | grep -q "^READY	1\."
+check $? 0 "readiness notified on ready_fd"
+./taskmasterctl --socket $socket status --tsv --fields state dep-silent | grep -qx "FATAL"
+check $? 0 "ready_timeout"
+./taskmasterctl --socket $socket status --tsv --fields state dep-needs-broken | grep -qx "STOPPED"
+check $? 0 "failed dependency blocks dependents"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
+grep "Terminated\.$" depends.log | grep -o "dep-[a-z]*" | grep -v dep-other | tr '\n' ' ' | grep -qx "dep-app dep-proxy dep-db "
+check $? 0 "dependents stop first"
+grep -q "killed (SIGKILL)" depends.log
+check $? 1 "only processes outliving the grace period are killed"
@@ -27,3 +27,17 @@ do
         echo -e "\033[31m FAIL: $i in $file \033[0m"
     fi
 done
+
+# dry run: the missing binary must be reported without starting anything
+if ./taskmaster --check --log-file errors.log --config-file ./test/errors_tests.yaml | grep -q "\[no-file-or-dir\] full_path"; then
+    echo -e "\033[32m PASS:  --check no-file-or-dir \033[0m"
+else
+    echo -e "\033[31m FAIL:  --check no-file-or-dir \033[0m"
+fi
+
+# nor is the log of the running one truncated
+if grep -q "SUCCESS: restart-time-good" errors.log; then
+    echo -e "\033[32m PASS:  --check keeps the log \033[0m"
+else
+    echo -e "\033[31m FAIL:  --check keeps the log \033[0m"
+fi
@@ -0,0 +1,33 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f jobs.log /tmp/taskmaster_jobs_out
+socket=/tmp/taskmaster_jobs_test.sock
+metrics=/tmp/taskmaster_jobs_metrics.sock
+
+(sleep 8) | ./taskmaster --log-file jobs.log --config-file ./test/jobs.yaml --socket $socket --metrics $metrics >/dev/null 2>&1 &
+sleep 0.5
+
+for i in 1 2 3 4; do
+    ./taskmasterctl --socket $socket submit workers -- 1 job$i 0 >/dev/null
+done
+./taskmasterctl --socket $socket jobs workers | grep -qx "2/2 running, 2/2 queued"
+check $? 0 "two jobs run, two are queued"
+./taskmasterctl --socket $socket submit workers -- 1 job5 0 | grep -q "queue full"
+check $? 0 "a submission past job_queue_size is rejected"
+sleep 2.5
+
+check $(grep -c "^default job[1-4]$" /tmp/taskmaster_jobs_out) 4 "every queued job ran"
+./taskmasterctl --socket $socket jobs workers | grep -Eq "^job 4 workers_job_4 exit 0 after 1\.[0-9]+s, waited (0\.9|1\.)[0-9]+s$"
+check $? 0 "exit codes, durations and waits are recorded"
+./taskmasterctl --socket $socket submit workers --env TAG=custom -- 0 --extra 3 >/dev/null
+sleep 0.5
+grep -q "^custom --extra$" /tmp/taskmaster_jobs_out && ./taskmasterctl --socket $socket jobs workers | grep -q "^job 5 workers_job_5 exit 3 "
+check $? 0 "a job's arguments and environment"
+curl -s --unix-socket $metrics http://localhost/metrics | grep -q "^taskmaster_job_wait_seconds_count 5$" &&
+    curl -s --unix-socket $metrics http://localhost/metrics | grep -q "^taskmaster_jobs_rejected_total 1$"
+check $? 0 "submit-to-start latency metrics"
+grep -q "bad-pool: should_restart: can't be 2 (always) for a job pool" jobs.log
+check $? 0 "a job pool can't restart always"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
+rm -f /tmp/taskmaster_jobs_out
@@ -0,0 +1,35 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f rolling.log /tmp/taskmaster_roll_broken
+socket=/tmp/taskmaster_rolling_test.sock
+
+pids() {
+    ./taskmasterctl --socket $socket status --tsv --fields pid --where state=READY $1 | tail -n +2 | sort
+}
+
+(sleep 8) | ./taskmaster --log-file rolling.log --config-file ./test/rolling.yaml --socket $socket >/dev/null 2>&1 &
+sleep 1
+
+before=$(pids roll-web)
+./taskmasterctl --socket $socket rolling-restart roll-web --batch 2 --max-unavailable 3 | grep -q "6 replica(s)"
+check $? 0 "rolling restart started"
+sleep 2
+grep -q "roll-web: rolling-restart roll-web: done, 6 replica(s)" rolling.log && grep -q "(2/6)" rolling.log && grep -q "(4/6)" rolling.log
+check $? 0 "replicas replaced in batches"
+after=$(pids roll-web)
+[ $(echo "$after" | wc -l) = 6 ] && [ -z "$(comm -12 <(echo "$before") <(echo "$after"))" ]
+check $? 0 "every replica is new and READY"
+
+touch /tmp/taskmaster_roll_broken
+before=$(pids roll-bad)
+./taskmasterctl --socket $socket rolling-restart roll-bad >/dev/null
+sleep 2
+grep -q "rolling-restart roll-bad: aborted, roll-bad is" rolling.log
+check $? 0 "a crash loop aborts the rollout"
+[ $(comm -12 <(echo "$before") <(pids roll-bad) | wc -l) = 3 ]
+check $? 0 "replicas left keep running"
+./taskmasterctl --socket $socket rolling-restart roll-web --batch 2 --max-unavailable 1 | grep -q "at least --batch"
+check $? 0 "max-unavailable below batch"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
+rm -f /tmp/taskmaster_roll_broken
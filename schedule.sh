@@ -0,0 +1,35 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f schedule.log /tmp/taskmaster_sched_*
+socket=/tmp/taskmaster_schedule_test.sock
+
+(sleep 12) | ./taskmaster --log-file schedule.log --config-file ./test/schedule.yaml --socket $socket >/dev/null 2>&1 &
+pid=$!
+sleep 3.5
+
+check $(wc -l < /tmp/taskmaster_sched_every) 3 "@every runs on time"
+./taskmasterctl --socket $socket runs job-every | grep -c " job-every [0-9.]*s exit 0$" | grep -qx 3
+check $? 0 "runs are recorded with durations and exit codes"
+grep -q "job-skip: schedule: the previous run is still running, skipped" schedule.log
+check $? 0 "overlap: skip"
+grep -q "job-queue: schedule: queued after the previous run" schedule.log && grep -q "job-queue: queued run" schedule.log
+check $? 0 "overlap: queue"
+grep -q "job-kill: schedule: stopping the previous run" schedule.log && ./taskmasterctl --socket $socket runs job-kill | grep -q "signal 15$"
+check $? 0 "overlap: kill-previous"
+./taskmasterctl --socket $socket runs job-cron | grep -Eq "^schedule: \*/15 3 \* \* 1-5, next run [0-9-]+ 03:(00|15|30|45):00$"
+check $? 0 "cron next run"
+grep -q "job-bad: schedule: must be a cron expression" schedule.log
+check $? 0 "malformed schedule"
+
+# the supervisor misses runs while it is stopped
+kill -STOP $pid
+sleep 3
+kill -CONT $pid
+sleep 0.5
+grep -q "job-every: schedule: missed [0-9]* run(s)" schedule.log
+check $? 0 "missed runs are skipped"
+grep -q "job-catchup: schedule: catching up [0-9]* missed run(s)" schedule.log && grep -q "job-catchup: catch-up run" schedule.log
+check $? 0 "missed runs are caught up with schedule_catch_up"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
+rm -f /tmp/taskmaster_sched_*
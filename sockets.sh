@@ -0,0 +1,56 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f sockets.log
+socket=/tmp/taskmaster_sockets_test.sock
+
+# one line from a tcp port
+ask() {
+    exec 5<>/dev/tcp/127.0.0.1/$1 && head -n 1 <&5
+    exec 5<&-
+}
+
+# same, after sending a line
+request() {
+    exec 5<>/dev/tcp/127.0.0.1/$1 && echo >&5 && head -n 1 <&5
+    exec 5<&-
+}
+
+(sleep 12) | ./taskmaster --log-file sockets.log --config-file ./test/sockets.yaml --socket $socket >/dev/null 2>&1 &
+sleep 1.5
+
+read fds pid self <<< "$(ask 47811)"
+[ "$fds" = 1 ] && [ "$pid" = "$self" ]
+check $? 0 "socket passed with LISTEN_FDS and LISTEN_PID"
+# the new process is not accepting yet: the connection waits in the backlog
+./taskmasterctl --socket $socket restart sock-echo >/dev/null
+read fds pid other <<< "$(ask 47811)"
+[ -n "$other" ] && [ "$other" != "$self" ]
+check $? 0 "connections wait during a restart"
+grep -q "sock-collision: ready_fd: must be 4 or more" sockets.log
+check $? 0 "ready_fd after the sockets"
+./taskmasterctl --socket $socket status --tsv --fields state sock-lazy | grep -qx "STOPPED"
+check $? 0 "lazy_start waits for a connection"
+curl -s --http0.9 --unix-socket /tmp/taskmaster_lazy_test.sock http://localhost/ | grep -q "^lazy [0-9]"
+check $? 0 "lazy_start on the first connection"
+./taskmaster --check --config-file ./test/sockets.yaml >/dev/null 2>&1
+./taskmaster --check --config-file ./test/sockets.yaml | grep -q "47811"
+check $? 1 "check does not bind"
+
+# sock-idle had no connection since it started
+./taskmasterctl --socket $socket status --tsv --fields state sock-idle | grep -qx "STOPPED" &&
+    grep -q "sock-idle: no connection for 1s, stopped until the next one" sockets.log
+check $? 0 "idle_timeout stops the program"
+read word first <<< "$(request 47813)"
+[ "$word" = idle ] && [ -n "$first" ]
+check $? 0 "restarted on the next connection"
+exec 6<>/dev/tcp/127.0.0.1/47813
+sleep 2.5
+echo >&6
+read word pid <&6
+exec 6<&-
+[ "$pid" = "$first" ]
+check $? 0 "an open connection keeps it running"
+grep -q "sock-idle-nosocket: idle_timeout: needs sockets to wait on" sockets.log
+check $? 0 "idle_timeout needs sockets"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
@@ -0,0 +1,31 @@
+#!/bin/bash
+source "$(dirname "$0")/test/lib.sh"
+rm -f spares.log
+socket=/tmp/taskmaster_spares_test.sock
+
+field() {
+    ./taskmasterctl --socket $socket status --tsv --fields $1 $2 | tail -n +2
+}
+
+(sleep 8) | ./taskmaster --log-file spares.log --config-file ./test/spares.yaml --socket $socket >/dev/null 2>&1 &
+sleep 2
+
+spare=$(field pid spare-web_spare_0)
+[ "$(field state spare-web_spare_0)" = SPARE ] && [ "$(ps -o stat= -p $spare | cut -c1)" = T ]
+check $? 0 "spare held once READY"
+kill -9 $(field pid spare-web_1)
+sleep 0.2
+[ "$(field state,pid spare-web_1)" = "$(printf 'READY\t%s' $spare)" ] && [ "$(ps -o stat= -p $spare | cut -c1)" != T ]
+check $? 0 "spare promoted in place of a dead replica"
+grep -q "spare-web_1: replaced by spare spare-web_spare_0 (pid $spare)" spares.log
+check $? 0 "promotion logged"
+sleep 1.5
+[ "$(field state spare-web_spare_0)" = SPARE ] && [ "$(field pid spare-web_spare_0)" != "$spare" ]
+check $? 0 "a new spare replaces the promoted one"
+grep -q "spare-bad: warm_spares: must be positive" spares.log
+check $? 0 "warm_spares is checked"
+./taskmasterctl --socket $socket stop spare-web >/dev/null
+[ -z "$(field state spare-web | grep -v STOPPED)" ] && ! grep -q "spare-web_spare_0: still running" spares.log
+check $? 0 "a held spare stops with its group"
+./taskmasterctl --socket $socket exit >/dev/null
+sleep 1
@@ -0,0 +1,243 @@
+#include "Autoscaler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/*
+** utime + stime + cutime + cstime, fields 14 to 17 of /proc/<pid>/stat.
+** the name (field 2) may hold spaces, fields are counted after its ')'
+*/
+static auto ReadTicks(int pid, unsigned long long & ticks) -> bool
+{
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    string line;
+
+    if (!std::getline(file, line))
+    {
+        return false;
+    }
+    size_t end = line.rfind(')');
+    if (end == string::npos)
+    {
+        return false;
+    }
+    std::istringstream fields(line.substr(end + 1));
+    string skipped;
+    unsigned long long utime, stime;
+    long long cutime, cstime;
+    // state (3) to cmajflt (13)
+    for (int i = 3; i <= 13; ++i)
+    {
+        fields >> skipped;
+    }
+    if (!(fields >> utime >> stime >> cutime >> cstime))
+    {
+        return false;
+    }
+    ticks = utime + stime + cutime + cstime;
+    return true;
+}
+
+};
+
+Autoscaler::Autoscaler() {}
+
+Autoscaler::~Autoscaler() {}
+
+int Autoscaler::sample(
+    const ProgramSpec & spec,
+    const std::vector<int> & pids,
+    int current,
+    int & replicas,
+    double & value,
+    string & error)
+{
+    Clock::time_point now = Clock::now();
+    std::unique_lock<std::mutex> states_lock(mStatesMutex);
+    State & state = mStates[spec.name];
+
+    states_lock.unlock();
+    if (now < state.nextSample)
+    {
+        return 0;
+    }
+    state.nextSample = now + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(spec.autoscaleInterval));
+    if (spec.autoscaleMetric == "cpu")
+    {
+        value = SampleCpu(state, pids, now);
+        if (value < 0.0)
+        {
+            return 0;
+        }
+    }
+    else if (spec.autoscaleMetric == "command")
+    {
+        if (RunCommand(spec.autoscaleCommand, std::max(spec.autoscaleInterval, 1.0), value, error) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mPushMutex);
+        auto it = mPushed.find(spec.name);
+        if (it == mPushed.end())
+        {
+            return 0;
+        }
+        value = it->second;
+    }
+
+    int wanted = std::clamp((int)std::ceil(value / spec.autoscaleTarget), spec.autoscaleMin, spec.autoscaleMax);
+    replicas = (wanted > current) ?
+        std::min(current + spec.autoscaleStep, wanted) :
+        std::max(current - spec.autoscaleStep, wanted);
+    auto cooldown = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(spec.autoscaleCooldown));
+    if (replicas != current && now < state.lastChange + cooldown)
+    {
+        replicas = current;
+    }
+    if (replicas != current)
+    {
+        state.lastChange = now;
+    }
+    return 1;
+}
+
+void Autoscaler::push(const string & program, double value)
+{
+    std::lock_guard<std::mutex> lock(mPushMutex);
+    mPushed[program] = value;
+}
+
+/*
+** the mean of the replicas seen at the previous sample, times the number of
+** replicas: a replica which was just added does not count as idle.
+** -1 until a replica was seen twice.
+*/
+double Autoscaler::SampleCpu(State & state, const std::vector<int> & pids, Clock::time_point now)
+{
+    static const double TicksPerSecond = ::sysconf(_SC_CLK_TCK);
+    std::unordered_map<int, unsigned long long> ticks;
+    double elapsed = std::chrono::duration<double>(now - state.lastSample).count();
+    double total = 0.0;
+    size_t n_measured = 0;
+
+    for (int pid : pids)
+    {
+        unsigned long long t;
+        if (!ReadTicks(pid, t))
+        {
+            continue;
+        }
+        ticks[pid] = t;
+        auto previous = state.ticks.find(pid);
+        if (previous != state.ticks.end() && t >= previous->second)
+        {
+            total += (t - previous->second) / TicksPerSecond / elapsed;
+            ++n_measured;
+        }
+    }
+    state.ticks = std::move(ticks);
+    state.lastSample = now;
+    return (n_measured == 0) ? -1.0 : total / n_measured * pids.size();
+}
+
+/*
+** the first number on the command's stdout. the command must exit with 0,
+** within timeout seconds: past it, the command and what it started are killed
+*/
+int Autoscaler::RunCommand(const string & command, double timeout, double & value, string & error)
+{
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(timeout));
+    int fds[2];
+    string output;
+    char buffer[256];
+    ssize_t size = 1;
+    int status;
+    bool is_timed_out = false;
+
+    // close-on-exec, so that processes started meanwhile don't keep the pipe
+    if (::pipe2(fds, O_CLOEXEC) == -1)
+    {
+        error = string("autoscale_command: ") + std::strerror(errno);
+        return 1;
+    }
+    pid_t pid = ::fork();
+    if (pid == -1)
+    {
+        error = string("autoscale_command: ") + std::strerror(errno);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return 1;
+    }
+    if (pid == 0)
+    {
+        // a group of its own, killed as a whole
+        ::setpgid(0, 0);
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::execl("/bin/sh", "sh", "-c", command.c_str(), (char *)nullptr);
+        ::_exit(127);
+    }
+    ::setpgid(pid, pid);
+    ::close(fds[1]);
+    while (size > 0)
+    {
+        int left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        struct pollfd fd = {fds[0], POLLIN, 0};
+        int ret = (left > 0) ? ::poll(&fd, 1, left) : 0;
+        if (ret == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret <= 0)
+        {
+            is_timed_out = ret == 0;
+            ::kill(-pid, SIGKILL);
+            break;
+        }
+        if ((size = ::read(fds[0], buffer, sizeof(buffer))) > 0)
+        {
+            output.append(buffer, size);
+        }
+    }
+    ::close(fds[0]);
+    while (::waitpid(pid, &status, 0) == -1 && errno == EINTR)
+    {}
+    if (is_timed_out)
+    {
+        std::ostringstream message;
+        message << "autoscale_command: timed out after " << timeout << "s (" << command << ")";
+        error = message.str();
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        error = "autoscale_command: failed (" + command + ")";
+        return 1;
+    }
+    char *end = nullptr;
+    value = std::strtod(output.c_str(), &end);
+    if (end == output.c_str() || !std::isfinite(value))
+    {
+        error = "autoscale_command: printed no number (" + command + ")";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ProgramSpec.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+
+/*
+** replica counts of the programs which set an autoscale_metric:
+**   cpu      cores used by the replicas (utime + stime of /proc/<pid>/stat,
+**            their reaped children included), between two samples
+**   command  the number autoscale_command prints on its stdout (run by /bin/sh,
+**            killed if it runs longer than autoscale_interval, or 1s)
+**   push     the last number sent with the push-metric command
+** the program asks for ceil(metric / autoscale_target) replicas, within
+** autoscale_min and autoscale_max, moving by autoscale_step at most, and not
+** again until autoscale_cooldown elapsed since its last change.
+**
+** sample() is called from any thread, for one program at a time. push() from any.
+*/
+class Autoscaler {
+public:
+        typedef std::chrono::steady_clock Clock;
+
+        /*
+        ** xtors
+        */
+        Autoscaler();
+        ~Autoscaler();
+
+        /*
+        ** business logic
+        */
+        // once autoscale_interval elapsed since the last sample of the program:
+        // returns 1 with the metric in value and the replica count the program
+        // asks for in replicas, or -1 and fills error. 0 if not due, or no
+        // value was pushed yet.
+        int sample(
+            const ProgramSpec & spec,
+            const std::vector<int> & pids,
+            int current,
+            int & replicas,
+            double & value,
+            string & error);
+        void push(const string & program, double value);
+private:
+        typedef struct State {
+            Clock::time_point nextSample;
+            Clock::time_point lastChange;
+            // cpu: ticks of each replica at the last sample
+            Clock::time_point lastSample;
+            std::unordered_map<int, unsigned long long> ticks;
+        } State;
+
+        /*
+        ** private functions
+        */
+        static double SampleCpu(State & state, const std::vector<int> & pids, Clock::time_point now);
+        static int RunCommand(const string & command, double timeout, double & value, string & error);
+
+        /*
+        ** class members
+        */
+        // guards the map, each State is only used by the sample of its program
+        std::mutex mStatesMutex;
+        std::unordered_map<string, State> mStates;
+        // pushed values, by program
+        std::mutex mPushMutex;
+        std::unordered_map<string, double> mPushed;
+};
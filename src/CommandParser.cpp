@@ -0,0 +1,292 @@
+#include "CommandParser.hpp"
+
+#include <algorithm>
+
+namespace {
+
+static auto IsBlank(char c) -> bool
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static auto IsSpecial(char c) -> bool
+{
+    return c == '\'' || c == '"' || c == '\\';
+}
+
+};
+
+CommandParser::CommandParser() :
+    mNodes(1, Node{-1, {}}),
+    mCommand(nullptr)
+{}
+
+CommandParser::~CommandParser() {}
+
+size_t CommandParser::add(const CommandSpec & spec)
+{
+    size_t node = 0;
+
+    for (char c : spec.name)
+    {
+        auto & children = mNodes[node].children;
+        auto child = std::lower_bound(children.begin(), children.end(), c,
+            [] (const std::pair<char, size_t> & entry, char key) { return entry.first < key; });
+        if (child != children.end() && child->first == c)
+        {
+            node = child->second;
+            continue;
+        }
+        // mNodes may grow: the children vector is not used past this point
+        children.insert(child, {c, mNodes.size()});
+        node = mNodes.size();
+        mNodes.push_back(Node{-1, {}});
+    }
+    mCommands.push_back(spec);
+    mCommands.back().id = mCommands.size() - 1;
+    mNodes[node].command = mCommands.size() - 1;
+    return mCommands.size() - 1;
+}
+
+const CommandSpec * CommandParser::find(std::string_view name) const
+{
+    size_t node = 0;
+
+    for (char c : name)
+    {
+        auto & children = mNodes[node].children;
+        // kept sorted by add()
+        auto child = std::lower_bound(children.begin(), children.end(), c,
+            [] (const std::pair<char, size_t> & entry, char key) { return entry.first < key; });
+        if (child == children.end() || child->first != c)
+        {
+            return nullptr;
+        }
+        node = child->second;
+    }
+    return (mNodes[node].command == -1) ? nullptr : &mCommands[mNodes[node].command];
+}
+
+int CommandParser::Tokenize(
+    std::string_view line,
+    std::vector<std::string_view> & words,
+    string & storage,
+    string & error)
+{
+    size_t i = 0;
+
+    words.clear();
+    storage.clear();
+    // unquoting only ever shrinks words: the views into storage stay valid
+    if (storage.capacity() < line.size())
+    {
+        storage.reserve(line.size());
+    }
+    while (i < line.size())
+    {
+        while (i < line.size() && IsBlank(line[i]))
+        {
+            ++i;
+        }
+        if (i == line.size())
+        {
+            break;
+        }
+        size_t start = i;
+        while (i < line.size() && !IsBlank(line[i]) && !IsSpecial(line[i]))
+        {
+            ++i;
+        }
+        if (i == line.size() || IsBlank(line[i]))
+        {
+            words.push_back(line.substr(start, i - start));
+            continue;
+        }
+
+        size_t begin = storage.size();
+        storage.append(line.substr(start, i - start));
+        while (i < line.size() && !IsBlank(line[i]))
+        {
+            char c = line[i];
+            if (c == '\'')
+            {
+                size_t end = line.find('\'', i + 1);
+                if (end == std::string_view::npos)
+                {
+                    error = "unterminated quote: " + string(line.substr(i));
+                    return 1;
+                }
+                storage.append(line.substr(i + 1, end - i - 1));
+                i = end + 1;
+            }
+            else if (c == '"')
+            {
+                for (++i; i < line.size() && line[i] != '"'; ++i)
+                {
+                    if (line[i] == '\\' && i + 1 < line.size())
+                    {
+                        ++i;
+                    }
+                    storage.push_back(line[i]);
+                }
+                if (i == line.size())
+                {
+                    error = "unterminated quote: " + string(line.substr(start));
+                    return 1;
+                }
+                ++i;
+            }
+            else if (c == '\\')
+            {
+                if (i + 1 == line.size())
+                {
+                    error = "nothing to escape after '\\'";
+                    return 1;
+                }
+                storage.push_back(line[i + 1]);
+                i += 2;
+            }
+            else
+            {
+                storage.push_back(c);
+                ++i;
+            }
+        }
+        words.push_back(std::string_view(storage).substr(begin));
+    }
+    return 0;
+}
+
+int CommandParser::parse(std::string_view line, string & error)
+{
+    mCommand = nullptr;
+    mArgs.clear();
+    mOptions.clear();
+    if (Tokenize(line, mWords, mStorage, error) != 0)
+    {
+        return 1;
+    }
+    if (mWords.empty())
+    {
+        return 0;
+    }
+
+    const CommandSpec *spec = find(mWords.front());
+    if (spec == nullptr)
+    {
+        error = "Command not found: " + string(line);
+        return 1;
+    }
+    bool has_options = true;
+    for (size_t i = 1; i < mWords.size(); ++i)
+    {
+        std::string_view word = mWords[i];
+        if (has_options && word == "--")
+        {
+            has_options = false;
+            continue;
+        }
+        if (!has_options || word.size() <= 2 || word.substr(0, 2) != "--")
+        {
+            mArgs.push_back(word);
+            continue;
+        }
+        const OptionSpec *option = findOption(*spec, word);
+        if (option == nullptr)
+        {
+            error = spec->name + ": unknown option " + string(word);
+            return 1;
+        }
+        std::string_view value;
+        if (option->hasValue)
+        {
+            if (i + 1 == mWords.size())
+            {
+                error = spec->name + ": " + option->name + " needs a value";
+                return 1;
+            }
+            value = mWords[++i];
+        }
+        mOptions.emplace_back(word, value);
+    }
+
+    if (spec->targets == TargetsRequired && mArgs.empty())
+    {
+        error = spec->name + ": missing target (name, group, glob or all)";
+        return 1;
+    }
+    if (spec->targets == TargetsNone && mArgs.size() < spec->minArgs)
+    {
+        error = spec->name + ": missing argument";
+        return 1;
+    }
+    if (spec->targets == TargetsNone && mArgs.size() > spec->maxArgs)
+    {
+        error = spec->name + ((spec->maxArgs == 0) ? ": takes no argument" : ": too many arguments");
+        return 1;
+    }
+    mCommand = spec;
+    return 0;
+}
+
+const CommandSpec * CommandParser::getCommand() const
+{
+    return mCommand;
+}
+
+const std::vector<std::string_view> & CommandParser::getArgs() const
+{
+    return mArgs;
+}
+
+bool CommandParser::hasOption(std::string_view name) const
+{
+    return std::any_of(mOptions.begin(), mOptions.end(),
+        [name] (const std::pair<std::string_view, std::string_view> & option) { return option.first == name; });
+}
+
+/*
+** the last one wins if an option is repeated
+*/
+std::string_view CommandParser::getOption(std::string_view name, std::string_view fallback) const
+{
+    for (auto it = mOptions.rbegin(); it != mOptions.rend(); ++it)
+    {
+        if (it->first == name)
+        {
+            return it->second;
+        }
+    }
+    return fallback;
+}
+
+std::vector<std::string_view> CommandParser::getOptions(std::string_view name) const
+{
+    std::vector<std::string_view> values;
+
+    for (auto & option : mOptions)
+    {
+        if (option.first == name)
+        {
+            values.push_back(option.second);
+        }
+    }
+    return values;
+}
+
+const std::vector<CommandSpec> & CommandParser::getCommands() const
+{
+    return mCommands;
+}
+
+const OptionSpec * CommandParser::findOption(const CommandSpec & spec, std::string_view name) const
+{
+    for (auto & option : spec.options)
+    {
+        if (option.name == name)
+        {
+            return &option;
+        }
+    }
+    return nullptr;
+}
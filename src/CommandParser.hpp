@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::string;
+
+/*
+** what a command does with its positional words
+*/
+enum CommandTargets {
+    // plain arguments, counted against minArgs and maxArgs
+    TargetsNone,
+    // process names, groups, globs or all: at least one
+    TargetsRequired,
+    // same, "all" when none is given
+    TargetsDefaultAll,
+};
+
+typedef struct OptionSpec {
+    // with the dashes, eg: "--fields"
+    string name;
+    // the option takes the next word as its value
+    bool hasValue = false;
+} OptionSpec;
+
+typedef struct CommandSpec {
+    string name;
+    CommandTargets targets = TargetsNone;
+    size_t minArgs = 0;
+    size_t maxArgs = 0;
+    std::vector<OptionSpec> options = {};
+    // index in the order commands were added, set by CommandParser::add
+    size_t id = 0;
+} CommandSpec;
+
+/*
+** splits a line into words and matches it against the known commands.
+**
+** words are separated by blanks. 'single quotes' keep everything, "double
+** quotes" and words outside quotes take \ as an escape. words without quotes
+** or escapes are views of the line itself; the others are unquoted into a
+** buffer which is reserved for the whole line first, so views never move.
+** commands are found in a trie of their names. words after "--" are
+** positional, even if they start with dashes.
+**
+** the parser keeps its buffers between lines: once they grew to the longest
+** line, parsing and dispatching a line allocates nothing. the views returned
+** are valid until the next parse() and as long as the line.
+*/
+class CommandParser {
+public:
+        /*
+        ** xtors
+        */
+        CommandParser();
+        ~CommandParser();
+
+        /*
+        ** business logic
+        */
+        // returns the id of the command
+        size_t add(const CommandSpec & spec);
+        // returns 1 and fills error if the line is not a valid command.
+        // an empty line is valid, with no command
+        int parse(std::string_view line, string & error);
+        const CommandSpec * find(std::string_view name) const;
+
+        // returns 1 and fills error on an unterminated quote or a trailing '\'
+        static int Tokenize(
+            std::string_view line,
+            std::vector<std::string_view> & words,
+            string & storage,
+            string & error);
+
+        /*
+        ** get/setters
+        */
+        // the command of the last parsed line, null if it was empty
+        const CommandSpec * getCommand() const;
+        // positional words: targets, or arguments
+        const std::vector<std::string_view> & getArgs() const;
+        bool hasOption(std::string_view name) const;
+        std::string_view getOption(std::string_view name, std::string_view fallback = {}) const;
+        // every value of a repeated option, in order
+        std::vector<std::string_view> getOptions(std::string_view name) const;
+        const std::vector<CommandSpec> & getCommands() const;
+private:
+        typedef struct Node {
+            // id of the command ending here, -1 if none
+            long command;
+            // sorted by character
+            std::vector<std::pair<char, size_t> > children;
+        } Node;
+
+        /*
+        ** private functions
+        */
+        const OptionSpec * findOption(const CommandSpec & spec, std::string_view name) const;
+
+        /*
+        ** class members
+        */
+        std::vector<CommandSpec> mCommands;
+        // root is mNodes[0]
+        std::vector<Node> mNodes;
+
+        // last parsed line
+        std::vector<std::string_view> mWords;
+        string mStorage;
+        const CommandSpec * mCommand;
+        std::vector<std::string_view> mArgs;
+        std::vector<std::pair<std::string_view, std::string_view> > mOptions;
+};
@@ -0,0 +1,352 @@
+#include "ConfigLoader.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <glob.h>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+#include <unordered_map>
+
+// anonymous namespace
+namespace {
+
+static auto SameTime(const struct timespec &a, const struct timespec &b) -> bool
+{
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+static auto DirName(const string &path) -> string
+{
+    auto pos = path.rfind('/');
+    if (pos == string::npos)
+    {
+        return ".";
+    }
+    return path.substr(0, (pos == 0) ? 1 : pos);
+}
+
+/*
+** append every path matching pattern to out, in glob(3) (sorted) order
+*/
+static auto Glob(const string &pattern, std::vector<string> &out) -> void
+{
+    glob_t result;
+
+    if (::glob(pattern.c_str(), 0, NULL, &result) == 0)
+    {
+        for (size_t i = 0; i < result.gl_pathc; ++i)
+        {
+            out.push_back(result.gl_pathv[i]);
+        }
+    }
+    ::globfree(&result);
+}
+
+/*
+** (re)parse a single fragment. the file is only read again if its mtime moved,
+** and only handed to the YAML parser if its content hash changed.
+** runs on a worker thread: must only touch `fragment`.
+*/
+static auto ParseFragment(ConfigFragment &fragment) -> void
+{
+    struct stat st;
+
+    if (::stat(fragment.path.c_str(), &st) == -1)
+    {
+        fragment.valid = false;
+        fragment.changed = true;
+        fragment.error = "YAML::BadFile.";
+        return ;
+    }
+    if (fragment.valid && SameTime(st.st_mtim, fragment.mtime))
+    {
+        fragment.changed = false;
+        return ;
+    }
+
+    std::ifstream file(fragment.path);
+    if (!file)
+    {
+        fragment.valid = false;
+        fragment.changed = true;
+        fragment.error = std::strerror(errno);
+        return ;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    size_t hash = std::hash<string>{}(content.str());
+    fragment.mtime = st.st_mtim;
+    if (fragment.valid && hash == fragment.hash)
+    {
+        fragment.changed = false;
+        return ;
+    }
+
+    fragment.hash = hash;
+    fragment.changed = true;
+    try {
+        fragment.root = YAML::Load(content.str());
+    } catch (const YAML::Exception &e) {
+        fragment.valid = false;
+        fragment.error = e.what();
+        return ;
+    }
+    if (!fragment.root.IsMap() ||
+        (!fragment.root["supervisor-processes"] && !fragment.root["include"]))
+    {
+        fragment.valid = false;
+        fragment.error = "supervisor-processes node not found.";
+        return ;
+    }
+    fragment.valid = true;
+    fragment.error.clear();
+}
+};
+
+ConfigLoader::ConfigLoader() {}
+
+ConfigLoader::ConfigLoader(const string &config_path, const string &config_dir) :
+    mConfigPath(config_path),
+    mConfigDir(config_dir)
+{}
+
+ConfigLoader::~ConfigLoader() {}
+
+/*
+** discover and parse every fragment: the roots first, then whatever their
+** `include:` globs point to, one wave at a time. each wave is parsed in parallel,
+** each fragment into its own YAML::Node tree.
+** returns 1 if no fragment could be loaded.
+*/
+int ConfigLoader::load(std::fstream &log_file)
+{
+    std::set<string> seen;
+    std::vector<string> wave = discoverRoots();
+    bool has_valid_fragment = false;
+
+    mOrder.clear();
+    while (!wave.empty())
+    {
+        std::vector<string> to_parse;
+        for (auto &path : wave)
+        {
+            if (seen.insert(path).second)
+            {
+                to_parse.push_back(path);
+                mOrder.push_back(path);
+            }
+        }
+        parseFragments(to_parse);
+
+        std::vector<string> next_wave;
+        for (auto &path : to_parse)
+        {
+            auto includes = expandIncludes(mFragments[path]);
+            next_wave.insert(next_wave.end(), includes.begin(), includes.end());
+        }
+        wave = std::move(next_wave);
+    }
+
+    // forget fragments which are not referenced anymore
+    std::erase_if(mFragments, [&seen](const auto &f) { return seen.count(f.first) == 0; });
+
+    mErrors.clear();
+    mOwners.clear();
+    for (auto &path : mOrder)
+    {
+        const ConfigFragment &fragment = mFragments[path];
+        if (!fragment.valid)
+        {
+            Utils::LogError(log_file, path, fragment.error);
+            mErrors.push_back({path, "file", fragment.error});
+            continue;
+        }
+        has_valid_fragment = true;
+        // the first fragment defining a name owns it
+        for (auto entry : fragment.root["supervisor-processes"])
+        {
+            const YAML::Node name = entry.second["name"];
+            if (!name || !name.IsScalar())
+            {
+                continue;
+            }
+            auto [owner, inserted] = mOwners.emplace(name.Scalar(), path);
+            if (!inserted)
+            {
+                string message = "duplicate program name, defined in " + owner->second +
+                    " and " + path + ". Ignoring the latter.";
+                Utils::LogError(log_file, name.Scalar(), message);
+                mErrors.push_back({name.Scalar(), "name", message});
+            }
+        }
+    }
+    return has_valid_fragment ? 0 : 1;
+}
+
+/*
+** flatten the `supervisor-processes` of every valid fragment, in discovery order.
+** definitions of a name which another fragment owns are dropped (see load).
+** with changed_only, only programs from fragments modified since the last load are returned.
+*/
+std::vector<ProgramNode> ConfigLoader::getPrograms(bool changed_only) const
+{
+    std::vector<ProgramNode> out;
+
+    for (auto &path : mOrder)
+    {
+        const ConfigFragment &fragment = mFragments.at(path);
+        if (!fragment.valid || (changed_only && !fragment.changed))
+        {
+            continue;
+        }
+        const YAML::Node processes = fragment.root["supervisor-processes"];
+        for (auto it = processes.begin(); it != processes.end(); ++it)
+        {
+            const YAML::Node name = it->second["name"];
+            if (name && name.IsScalar() && mOwners.at(name.Scalar()) != path)
+            {
+                continue;
+            }
+            out.push_back({&fragment, it->second});
+        }
+    }
+    return out;
+}
+
+/*
+** fragments which failed to parse and duplicate names, as of the last load
+*/
+const std::vector<ConfigError> &ConfigLoader::getErrors() const
+{
+    return mErrors;
+}
+
+std::vector<string> ConfigLoader::discoverRoots() const
+{
+    std::vector<string> roots;
+
+    if (!mConfigPath.empty())
+    {
+        roots.push_back(mConfigPath);
+    }
+    if (!mConfigDir.empty())
+    {
+        std::vector<string> entries;
+        Glob(mConfigDir + "/*.yaml", entries);
+        Glob(mConfigDir + "/*.yml", entries);
+        std::sort(entries.begin(), entries.end());
+        roots.insert(roots.end(), entries.begin(), entries.end());
+    }
+    return roots;
+}
+
+/*
+** `include:` is either a single glob or a list of globs,
+** relative paths are resolved from the including file's directory
+*/
+std::vector<string> ConfigLoader::expandIncludes(const ConfigFragment &fragment) const
+{
+    std::vector<string> out;
+    std::vector<string> patterns;
+
+    if (!fragment.valid || !fragment.root["include"])
+    {
+        return out;
+    }
+    const YAML::Node include = fragment.root["include"];
+    if (include.IsScalar())
+    {
+        patterns.push_back(include.as<string>());
+    }
+    else if (include.IsSequence())
+    {
+        for (auto p : include)
+        {
+            patterns.push_back(p.as<string>());
+        }
+    }
+    for (auto &pattern : patterns)
+    {
+        if (pattern.empty())
+        {
+            continue;
+        }
+        Glob((pattern.front() == '/') ? pattern : DirName(fragment.path) + "/" + pattern, out);
+    }
+    return out;
+}
+
+void ConfigLoader::parseFragments(const std::vector<string> &paths)
+{
+    std::vector<ConfigFragment *> fragments;
+
+    // create the cache entries up front, workers never modify the map itself
+    for (auto &path : paths)
+    {
+        auto [it, inserted] = mFragments.try_emplace(path);
+        if (inserted)
+        {
+            it->second.path = path;
+            it->second.hash = 0;
+            it->second.valid = false;
+            it->second.changed = true;
+        }
+        fragments.push_back(&it->second);
+    }
+    Utils::ParallelFor(fragments.size(), [&fragments](size_t i) {
+        ParseFragment(*fragments[i]);
+    });
+}
+
+const string &ConfigLoader::getConfigPath() const
+{
+    return mConfigPath;
+}
+
+const string &ConfigLoader::getConfigDir() const
+{
+    return mConfigDir;
+}
+
+size_t ConfigLoader::getNumberOfFragments() const
+{
+    return mOrder.size();
+}
+
+/*
+** whether the fragment is still part of the config and was not read again
+** by the last load
+*/
+bool ConfigLoader::isUnchanged(const string &path) const
+{
+    auto it = mFragments.find(path);
+
+    if (it == mFragments.end() || std::find(mOrder.begin(), mOrder.end(), path) == mOrder.end())
+    {
+        return false;
+    }
+    return it->second.valid && !it->second.changed;
+}
+
+/*
+** whether a valid fragment defines the name, well formed or not: a reload
+** removes the programs which are not anymore
+*/
+bool ConfigLoader::isDefined(const string &name) const
+{
+    return mOwners.contains(name);
+}
+
+/*
+** the fragment is still part of the config, but could not be parsed
+*/
+bool ConfigLoader::isInvalid(const string &path) const
+{
+    auto it = mFragments.find(path);
+
+    return it != mFragments.end() && !it->second.valid;
+}
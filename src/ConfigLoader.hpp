@@ -0,0 +1,90 @@
+#pragma once
+
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using std::string;
+
+/*
+** one parsed config file: either the main --config-file, a file
+** found in --config-dir, or a file pulled in by an `include:` glob
+*/
+typedef struct ConfigFragment {
+    string path;
+    struct timespec mtime;
+    size_t hash;
+    bool changed;
+    bool valid;
+    string error;
+    YAML::Node root;
+} ConfigFragment;
+
+/*
+** a fragment which failed to parse, or a duplicate program name
+*/
+typedef struct ConfigError {
+    // the fragment's path, or the program's name
+    string source;
+    string field;
+    string message;
+} ConfigError;
+
+/*
+** a program entry of `supervisor-processes`, along with the fragment
+** it was defined in
+*/
+typedef struct ProgramNode {
+    const ConfigFragment * fragment;
+    YAML::Node node;
+} ProgramNode;
+
+class ConfigLoader {
+public:
+        /*
+        ** xtors
+        */
+        ConfigLoader();
+        ConfigLoader(const string &config_path, const string &config_dir);
+        ~ConfigLoader();
+
+        /*
+        ** business logic
+        */
+        int load(std::fstream &log_file);
+        std::vector<ProgramNode> getPrograms(bool changed_only) const;
+
+        /*
+        ** get/setters
+        */
+        const string &getConfigPath() const;
+        const string &getConfigDir() const;
+        size_t getNumberOfFragments() const;
+        const std::vector<ConfigError> &getErrors() const;
+        bool isDefined(const string &name) const;
+        bool isUnchanged(const string &path) const;
+        bool isInvalid(const string &path) const;
+private:
+        /*
+        ** private functions
+        */
+        std::vector<string> discoverRoots() const;
+        std::vector<string> expandIncludes(const ConfigFragment &fragment) const;
+        void parseFragments(const std::vector<string> &paths);
+
+        /*
+        ** class members
+        */
+        string mConfigPath;
+        string mConfigDir;
+        // fragments in discovery order, used to merge deterministically
+        std::vector<string> mOrder;
+        // cache kept across reloads, keyed by path
+        std::map<string, ConfigFragment> mFragments;
+        // program name -> path of the fragment defining it, see load
+        std::unordered_map<string, string> mOwners;
+        std::vector<ConfigError> mErrors;
+};
@@ -0,0 +1,113 @@
+#include "ControlProtocol.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ControlProtocol {
+
+void AppendFrame(string & out, const string & payload)
+{
+    uint32_t size = payload.size();
+    char header[4] = {
+        (char)(size >> 24), (char)(size >> 16), (char)(size >> 8), (char)size
+    };
+
+    out.append(header, 4);
+    out.append(payload);
+}
+
+int ExtractFrame(string & buffer, string & payload)
+{
+    if (buffer.size() < 4)
+    {
+        return 0;
+    }
+    const unsigned char * header = (const unsigned char *)buffer.data();
+    uint32_t size = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16) |
+        ((uint32_t)header[2] << 8) | (uint32_t)header[3];
+    if (size > MaxFrameSize)
+    {
+        return -1;
+    }
+    if (buffer.size() < 4 + size)
+    {
+        return 0;
+    }
+    payload.assign(buffer, 4, size);
+    buffer.erase(0, 4 + size);
+    return 1;
+}
+
+int Connect(const string & socket_path)
+{
+    struct sockaddr_un addr = {};
+    int fd;
+
+    if (socket_path.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if ((fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1)
+    {
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int SendFrame(int fd, const string & payload)
+{
+    string frame;
+    size_t sent = 0;
+
+    AppendFrame(frame, payload);
+    while (sent < frame.size())
+    {
+        ssize_t n = ::send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        sent += n;
+    }
+    return 0;
+}
+
+int ReceiveFrame(int fd, string & buffer, string & payload)
+{
+    char chunk[4096];
+
+    for (;;)
+    {
+        int ret = ExtractFrame(buffer, payload);
+        if (ret != 0)
+        {
+            return (ret == 1) ? 0 : -1;
+        }
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        buffer.append(chunk, n);
+    }
+}
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+using std::string;
+
+/*
+** framing used on the control socket, in both directions:
+**   [4 bytes: payload length, big endian][payload]
+** a request payload is a command line, as typed in the REPL.
+** a response payload is one status byte (see ResponseStatus)
+** followed by the command's output.
+*/
+namespace ControlProtocol {
+
+    const uint32_t MaxFrameSize = 1 << 20;
+
+    typedef enum ResponseStatus {
+        Ok = 0,
+        Error = 1
+    } ResponseStatus;
+
+    void AppendFrame(string & out, const string & payload);
+
+    /*
+    ** if buffer starts with a complete frame, move its payload out and
+    ** return 1. returns 0 if more bytes are needed, -1 if the frame is too large.
+    */
+    int ExtractFrame(string & buffer, string & payload);
+
+    /*
+    ** blocking helpers for clients. buffer keeps what was received past
+    ** the frame, pass it again to the next ReceiveFrame on the same fd
+    */
+    int Connect(const string & socket_path);
+    int SendFrame(int fd, const string & payload);
+    int ReceiveFrame(int fd, string & buffer, string & payload);
+};
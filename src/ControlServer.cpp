@@ -0,0 +1,356 @@
+#include "ControlServer.hpp"
+#include "ControlProtocol.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+ControlServer::ControlServer(EventLoop & loop, const string & socket_path, Handler handler) :
+    mLoop(loop),
+    mSocketPath(socket_path),
+    mHandler(handler),
+    mListenFd(-1),
+    mNextClientId(0),
+    mIsStopping(false),
+    mNumberOfDroppedEvents(0),
+    mNumberOfDroppedSubscribers(0)
+{}
+
+ControlServer::~ControlServer()
+{
+    stop();
+    // the loop is expected to be stopped by now, fds are closed directly
+    for (auto & [fd, client] : mClients)
+    {
+        ::close(fd);
+    }
+    mClients.clear();
+    if (mListenFd != -1)
+    {
+        ::close(mListenFd);
+        ::unlink(mSocketPath.c_str());
+    }
+}
+
+/*
+** bind the socket and register it with the loop. a stale socket file left
+** by a previous run is replaced. returns -1 and sets errno on failure.
+*/
+int ControlServer::start()
+{
+    struct sockaddr_un addr = {};
+
+    if (mSocketPath.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    mListenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mListenFd == -1)
+    {
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, mSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(mSocketPath.c_str());
+    if (::bind(mListenFd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        ::listen(mListenFd, SOMAXCONN) == -1)
+    {
+        int err = errno;
+        ::close(mListenFd);
+        mListenFd = -1;
+        errno = err;
+        return -1;
+    }
+    mWorker = std::thread(&ControlServer::work, this);
+    mLoop.post([this] {
+        mLoop.addFd(mListenFd, EPOLLIN, [this](uint32_t) { onAccept(); });
+    });
+    return 0;
+}
+
+/*
+** stop running commands. the command in progress finishes and its answer is
+** posted to the loop, so stop the loop after this to still deliver it.
+*/
+void ControlServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        if (mIsStopping)
+        {
+            return ;
+        }
+        mIsStopping = true;
+    }
+    mQueueCondition.notify_all();
+    if (mWorker.joinable())
+    {
+        mWorker.join();
+    }
+}
+
+const string & ControlServer::getSocketPath() const
+{
+    return mSocketPath;
+}
+
+size_t ControlServer::getNumberOfClients() const
+{
+    return mClients.size();
+}
+
+size_t ControlServer::getNumberOfDroppedSubscribers() const
+{
+    return mNumberOfDroppedSubscribers;
+}
+
+/*
+** queue an event for the subscribers. events published until the loop
+** gets to them are sent together
+*/
+void ControlServer::publish(const Event & event)
+{
+    bool is_first;
+
+    {
+        std::lock_guard<std::mutex> lock(mEventMutex);
+        if (mPendingEvents.size() >= MaxPendingEvents)
+        {
+            ++mNumberOfDroppedEvents;
+            return ;
+        }
+        mPendingEvents.push_back(event);
+        is_first = mPendingEvents.size() == 1;
+    }
+    if (is_first)
+    {
+        mLoop.post([this] { deliverEvents(); });
+    }
+}
+
+void ControlServer::onAccept()
+{
+    for (;;)
+    {
+        int fd = ::accept4(mListenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1)
+        {
+            // EAGAIN: backlog drained
+            return ;
+        }
+        mClients[fd] = Client{mNextClientId++, "", "", nullptr};
+        mLoop.addFd(fd, EPOLLIN | EPOLLRDHUP, [this, fd](uint32_t events) {
+            onClientEvent(fd, events);
+        });
+    }
+}
+
+void ControlServer::onClientEvent(int fd, uint32_t events)
+{
+    auto it = mClients.find(fd);
+    if (it == mClients.end())
+    {
+        return ;
+    }
+    Client & client = it->second;
+
+    if (events & EPOLLOUT)
+    {
+        flush(fd, client);
+    }
+    if (events & EPOLLIN)
+    {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            client.in.append(buffer, n);
+        }
+        if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR))
+        {
+            closeClient(fd);
+            return ;
+        }
+
+        string payload;
+        int ret;
+        while ((ret = ControlProtocol::ExtractFrame(client.in, payload)) == 1)
+        {
+            if (client.subscription)
+            {
+                // a subscriber only listens
+                continue;
+            }
+            if (Subscription::IsSubscribeRequest(payload))
+            {
+                subscribe(fd, client, payload);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mQueueMutex);
+                mQueue.push_back({fd, client.id, std::move(payload)});
+            }
+            mQueueCondition.notify_one();
+        }
+        if (ret == -1)
+        {
+            closeClient(fd);
+            return ;
+        }
+    }
+    if (events & (EPOLLHUP | EPOLLERR))
+    {
+        closeClient(fd);
+    }
+}
+
+/*
+** called on the loop thread once the worker answered; the client may
+** have left in the meantime, and its fd may already belong to someone else
+*/
+void ControlServer::onResponse(int fd, uint64_t client_id, const string & frame)
+{
+    auto it = mClients.find(fd);
+    if (it == mClients.end() || it->second.id != client_id)
+    {
+        return ;
+    }
+    it->second.out.append(frame);
+    flush(fd, it->second);
+}
+
+void ControlServer::flush(int fd, Client & client)
+{
+    while (!client.out.empty())
+    {
+        ssize_t n = ::send(fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n == -1 && errno == EAGAIN)
+        {
+            mLoop.modifyFd(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+            return ;
+        }
+        if (n <= 0)
+        {
+            closeClient(fd);
+            return ;
+        }
+        client.out.erase(0, n);
+    }
+    mLoop.modifyFd(fd, EPOLLIN | EPOLLRDHUP);
+}
+
+void ControlServer::closeClient(int fd)
+{
+    mLoop.removeFd(fd);
+    mClients.erase(fd);
+    ::close(fd);
+}
+
+/*
+** answered on the loop thread: subscribing doesn't run a command
+*/
+void ControlServer::subscribe(int fd, Client & client, const string & request)
+{
+    auto subscription = std::make_shared<Subscription>();
+    string error, frame;
+
+    if (subscription->parse(request, error) != 0)
+    {
+        ControlProtocol::AppendFrame(frame, string(1, ControlProtocol::Error) + error + "\n");
+    }
+    else
+    {
+        client.subscription = subscription;
+        ControlProtocol::AppendFrame(frame, string(1, ControlProtocol::Ok) + "subscribed\n");
+    }
+    client.out.append(frame);
+    flush(fd, client);
+}
+
+void ControlServer::deliverEvents()
+{
+    std::vector<Event> events;
+    size_t n_dropped;
+
+    {
+        std::lock_guard<std::mutex> lock(mEventMutex);
+        events.swap(mPendingEvents);
+        n_dropped = mNumberOfDroppedEvents;
+        mNumberOfDroppedEvents = 0;
+    }
+    std::vector<int> slow_consumers;
+    for (auto & [fd, client] : mClients)
+    {
+        if (!client.subscription)
+        {
+            continue;
+        }
+        string lines;
+        for (auto & event : events)
+        {
+            if (client.subscription->matches(event))
+            {
+                lines += event.line + "\n";
+            }
+        }
+        if (n_dropped)
+        {
+            lines += "dropped " + std::to_string(n_dropped) + " event(s)\n";
+        }
+        if (lines.empty())
+        {
+            continue;
+        }
+        ControlProtocol::AppendFrame(client.out, string(1, ControlProtocol::Ok) + lines);
+        if (client.out.size() > MaxSubscriberBuffer)
+        {
+            slow_consumers.push_back(fd);
+            continue;
+        }
+        flush(fd, client);
+    }
+    for (int fd : slow_consumers)
+    {
+        ++mNumberOfDroppedSubscribers;
+        closeClient(fd);
+    }
+}
+
+/*
+** worker thread: run queued commands in order, hand the answers back to the loop
+*/
+void ControlServer::work()
+{
+    for (;;)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCondition.wait(lock, [this] { return mIsStopping || !mQueue.empty(); });
+            if (mIsStopping)
+            {
+                return ;
+            }
+            request = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        string output;
+        int ret = mHandler(request.payload, output);
+        string frame;
+        ControlProtocol::AppendFrame(frame, string(1, (ret == 0) ?
+            ControlProtocol::Ok :
+            ControlProtocol::Error) + output);
+        mLoop.post([this, fd = request.fd, id = request.clientId, frame = std::move(frame)] {
+            onResponse(fd, id, frame);
+        });
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "EventLoop.hpp"
+#include "Subscription.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+using std::string;
+
+/*
+** serves the control protocol (see ControlProtocol.hpp) on a unix socket.
+** sockets are handled on the event loop; commands run on a worker thread
+** so a slow command never holds up accepting, reading or answering other clients.
+**
+** a client which sends `subscribe ...` (see Subscription.hpp) gets a stream of
+** events instead: each frame holds every matching event published since the
+** previous one, one per line. a subscriber which doesn't read fast enough to keep
+** its buffer under MaxSubscriberBuffer is disconnected, publish() never waits.
+*/
+class ControlServer {
+public:
+        /*
+        ** fills response with the command's output, returns 0 on success
+        */
+        typedef std::function<int(const string & request, string & response)> Handler;
+
+        static const size_t MaxSubscriberBuffer = 1 << 20;
+        static const size_t MaxPendingEvents = 1 << 16;
+
+        /*
+        ** xtors
+        */
+        ControlServer(EventLoop & loop, const string & socket_path, Handler handler);
+        ~ControlServer();
+
+        /*
+        ** business logic
+        */
+        int start();
+        void stop();
+        // thread safe
+        void publish(const Event & event);
+
+        /*
+        ** get/setters
+        */
+        const string & getSocketPath() const;
+        size_t getNumberOfClients() const;
+        size_t getNumberOfDroppedSubscribers() const;
+private:
+        typedef struct Client {
+            uint64_t id;
+            string in;
+            string out;
+            // set once the client subscribed
+            std::shared_ptr<Subscription> subscription;
+        } Client;
+
+        typedef struct Request {
+            int fd;
+            uint64_t clientId;
+            string payload;
+        } Request;
+
+        /*
+        ** private functions
+        */
+        void onAccept();
+        void onClientEvent(int fd, uint32_t events);
+        void onResponse(int fd, uint64_t client_id, const string & frame);
+        void flush(int fd, Client & client);
+        void closeClient(int fd);
+        void subscribe(int fd, Client & client, const string & request);
+        void deliverEvents();
+        void work();
+
+        /*
+        ** class members
+        */
+        EventLoop & mLoop;
+        string mSocketPath;
+        Handler mHandler;
+        int mListenFd;
+        uint64_t mNextClientId;
+        // only touched on the loop thread
+        std::unordered_map<int, Client> mClients;
+
+        std::thread mWorker;
+        std::mutex mQueueMutex;
+        std::condition_variable mQueueCondition;
+        std::deque<Request> mQueue;
+        bool mIsStopping;
+
+        std::mutex mEventMutex;
+        std::vector<Event> mPendingEvents;
+        size_t mNumberOfDroppedEvents;
+        // only touched on the loop thread
+        size_t mNumberOfDroppedSubscribers;
+};
@@ -0,0 +1,130 @@
+#include "Daemon.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Daemon {
+
+namespace {
+
+static auto RedirectToNull(int fd) -> void
+{
+    int null_fd = ::open("/dev/null", O_RDWR | O_CLOEXEC);
+
+    if (null_fd == -1)
+    {
+        return ;
+    }
+    ::dup2(null_fd, fd);
+    ::close(null_fd);
+}
+
+};
+
+int Detach(int & notify_fd)
+{
+    int fds[2];
+
+    if (::pipe2(fds, O_CLOEXEC) == -1)
+    {
+        return -1;
+    }
+    pid_t pid = ::fork();
+    if (pid == -1)
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return -1;
+    }
+    if (pid > 0)
+    {
+        // wait for the daemon: one byte once ready, nothing if it exited first
+        char ready = 0;
+        ::close(fds[1]);
+        ::waitpid(pid, NULL, 0);
+        while (::read(fds[0], &ready, 1) == -1 && errno == EINTR)
+        {}
+        std::exit((ready == 1) ? 0 : 1);
+    }
+
+    // new session without a controlling terminal, and fork again so that
+    // the daemon is not a session leader and can never acquire one
+    ::close(fds[0]);
+    ::setsid();
+    pid = ::fork();
+    if (pid == -1)
+    {
+        std::_Exit(1);
+    }
+    if (pid > 0)
+    {
+        std::_Exit(0);
+    }
+    ::umask(022);
+    RedirectToNull(STDIN_FILENO);
+    notify_fd = fds[1];
+    return 0;
+}
+
+void Ready(int & notify_fd)
+{
+    char ready = 1;
+
+    if (notify_fd == -1)
+    {
+        return ;
+    }
+    // redirect first: the parent exits as soon as it reads
+    RedirectToNull(STDOUT_FILENO);
+    RedirectToNull(STDERR_FILENO);
+    while (::write(notify_fd, &ready, 1) == -1 && errno == EINTR)
+    {}
+    ::close(notify_fd);
+    notify_fd = -1;
+}
+
+int WritePidFile(const string & path)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd == -1)
+    {
+        return -1;
+    }
+    if (::flock(fd, LOCK_EX | LOCK_NB) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        return -1;
+    }
+    string pid = std::to_string(::getpid()) + "\n";
+    if (::ftruncate(fd, 0) == -1 ||
+        ::write(fd, pid.c_str(), pid.size()) != (ssize_t)pid.size())
+    {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+void RemovePidFile(const string & path, int fd)
+{
+    if (fd == -1)
+    {
+        return ;
+    }
+    // still locked: nobody else can have taken it over
+    ::unlink(path.c_str());
+    ::close(fd);
+}
+
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+using std::string;
+
+/*
+** running without a terminal (--daemon).
+**
+** Detach() double-forks: the process which called it waits until the daemon
+** reports it is ready (or died trying) and exits with 0 or 1, so that the
+** shell or the init script gets a meaningful status. stdout and stderr stay
+** attached until Ready(), error messages printed while starting are seen.
+*/
+namespace Daemon {
+
+    /*
+    ** returns in the daemon only, with notify_fd the end of the pipe Ready()
+    ** writes to. returns -1 if the first fork failed.
+    */
+    int Detach(int & notify_fd);
+
+    /*
+    ** tell the waiting parent the daemon started, then let go of the terminal
+    */
+    void Ready(int & notify_fd);
+
+    /*
+    ** write our pid to path and keep it locked as long as we run: a second
+    ** daemon with the same pidfile refuses to start. returns the locked fd,
+    ** -1 and sets errno on failure (EWOULDBLOCK: already running)
+    */
+    int WritePidFile(const string & path);
+    void RemovePidFile(const string & path, int fd);
+};
@@ -0,0 +1,143 @@
+#include "DependencyGraph.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <map>
+
+DependencyGraph::DependencyGraph() :
+    mNumberOfLevels(0)
+{}
+
+DependencyGraph::~DependencyGraph() {}
+
+void DependencyGraph::build(
+    const std::vector<std::shared_ptr<const ProgramSpec> > & specs,
+    std::vector<ValidationIssue> & issues)
+{
+    // ordered: the same config always gives the same issues
+    std::map<string, size_t> pending;
+    std::unordered_map<string, std::vector<string> > dependents;
+    std::vector<string> ready;
+
+    mNodes.clear();
+    mNumberOfLevels = 0;
+    for (auto & spec : specs)
+    {
+        mNodes[spec->name] = Node{{}, 0};
+    }
+    for (auto & spec : specs)
+    {
+        Node & node = mNodes[spec->name];
+        for (auto & dependency : spec->dependsOn)
+        {
+            if (dependency == spec->name || mNodes.count(dependency) == 0)
+            {
+                issues.push_back({spec->name, "depends_on",
+                    (dependency == spec->name) ? "depends on itself, ignored" : "unknown program " + dependency + ", ignored"});
+                continue;
+            }
+            if (std::find(node.dependencies.begin(), node.dependencies.end(), dependency) == node.dependencies.end())
+            {
+                node.dependencies.push_back(dependency);
+                dependents[dependency].push_back(spec->name);
+            }
+        }
+        pending[spec->name] = node.dependencies.size();
+    }
+
+    // Kahn's algorithm: a program gets its level once all of its dependencies have one
+    for (auto & [name, n_dependencies] : pending)
+    {
+        if (n_dependencies == 0)
+        {
+            ready.push_back(name);
+        }
+    }
+    while (!ready.empty())
+    {
+        string name = ready.back();
+        ready.pop_back();
+        pending.erase(name);
+        Node & node = mNodes[name];
+        for (auto & dependency : node.dependencies)
+        {
+            node.level = std::max(node.level, mNodes[dependency].level + 1);
+        }
+        mNumberOfLevels = std::max(mNumberOfLevels, node.level + 1);
+        for (auto & dependent : dependents[name])
+        {
+            if (--pending[dependent] == 0)
+            {
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    // what is left is in a cycle, or depends on one: edges between them go
+    if (pending.empty())
+    {
+        return ;
+    }
+    std::vector<string> cycle;
+    for (auto & [name, n_dependencies] : pending)
+    {
+        cycle.push_back(name);
+    }
+    for (auto & name : cycle)
+    {
+        Node & node = mNodes[name];
+        issues.push_back({name, "depends_on", "dependency cycle among " + Utils::JoinStrings(cycle, ", ") + ", ignored"});
+        node.dependencies.erase(std::remove_if(node.dependencies.begin(), node.dependencies.end(),
+            [&pending] (const string & dependency) { return pending.count(dependency) != 0; }),
+            node.dependencies.end());
+        node.level = 0;
+        for (auto & dependency : node.dependencies)
+        {
+            node.level = std::max(node.level, mNodes[dependency].level + 1);
+        }
+        mNumberOfLevels = std::max(mNumberOfLevels, node.level + 1);
+    }
+}
+
+std::vector<string> DependencyGraph::closure(const std::vector<string> & programs) const
+{
+    std::vector<string> out, stack(programs.begin(), programs.end());
+    std::unordered_map<string, bool> seen;
+
+    while (!stack.empty())
+    {
+        string name = stack.back();
+        stack.pop_back();
+        if (seen[name] || mNodes.count(name) == 0)
+        {
+            continue;
+        }
+        seen[name] = true;
+        out.push_back(name);
+        for (auto & dependency : mNodes.at(name).dependencies)
+        {
+            stack.push_back(dependency);
+        }
+    }
+    return out;
+}
+
+int DependencyGraph::getLevel(const string & program) const
+{
+    auto it = mNodes.find(program);
+
+    return (it == mNodes.end()) ? -1 : it->second.level;
+}
+
+int DependencyGraph::getNumberOfLevels() const
+{
+    return mNumberOfLevels;
+}
+
+const std::vector<string> & DependencyGraph::getDependencies(const string & program) const
+{
+    static const std::vector<string> none;
+    auto it = mNodes.find(program);
+
+    return (it == mNodes.end()) ? none : it->second.dependencies;
+}
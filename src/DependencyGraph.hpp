@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ProgramSpec.hpp"
+#include "Validator.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+
+/*
+** programs and their depends_on, as a DAG. built again after each (re)load.
+**
+** a program's level is 0 without dependencies, else one more than the highest
+** level among them: starting by increasing level, or stopping by decreasing
+** level, never runs a program before what it depends on. unknown dependencies
+** and cycles are reported; their edges are dropped so that every program
+** still gets a level.
+*/
+class DependencyGraph {
+public:
+        /*
+        ** xtors
+        */
+        DependencyGraph();
+        ~DependencyGraph();
+
+        /*
+        ** business logic
+        */
+        void build(
+            const std::vector<std::shared_ptr<const ProgramSpec> > & specs,
+            std::vector<ValidationIssue> & issues);
+        // the programs and everything they depend on, transitively
+        std::vector<string> closure(const std::vector<string> & programs) const;
+
+        /*
+        ** get/setters
+        */
+        // -1 for an unknown program
+        int getLevel(const string & program) const;
+        int getNumberOfLevels() const;
+        // without the dropped edges
+        const std::vector<string> & getDependencies(const string & program) const;
+private:
+        typedef struct Node {
+            std::vector<string> dependencies;
+            int level;
+        } Node;
+
+        /*
+        ** class members
+        */
+        std::unordered_map<string, Node> mNodes;
+        int mNumberOfLevels;
+};
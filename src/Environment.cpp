@@ -0,0 +1,165 @@
+#include "Environment.hpp"
+
+// anonymous namespace
+namespace {
+
+static auto KeyOf(const string & entry) -> std::string_view
+{
+    return std::string_view(entry).substr(0, entry.find('='));
+}
+};
+
+Environment::Environment() :
+    mBase(std::make_shared<const EnvironmentBlock>()),
+    mIsCached(false)
+{}
+
+Environment::Environment(std::shared_ptr<const EnvironmentBlock> base) :
+    mBase(base),
+    mIsCached(false)
+{}
+
+Environment::Environment(const Environment & other) :
+    mBase(other.mBase),
+    mOverrides(other.mOverrides),
+    mIsCached(false)
+{}
+
+Environment & Environment::operator=(const Environment & other)
+{
+    if (this != &other)
+    {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        mBase = other.mBase;
+        mOverrides = other.mOverrides;
+        mIsCached = false;
+    }
+    return *this;
+}
+
+Environment::~Environment() {}
+
+/*
+** build a block from a NULL terminated KEY=VALUE array (eg: main()'s envp).
+** when a key appears more than once, the last value wins.
+*/
+std::shared_ptr<const EnvironmentBlock> Environment::Intern(char *envp[])
+{
+    auto block = std::make_shared<EnvironmentBlock>();
+    std::unordered_map<string, size_t> positions;
+
+    for (; envp && *envp; ++envp)
+    {
+        string entry(*envp);
+        auto [it, inserted] = positions.emplace(KeyOf(entry), block->entries.size());
+        if (!inserted)
+        {
+            block->entries[it->second] = entry;
+            continue;
+        }
+        block->entries.push_back(entry);
+    }
+    // views can only be taken once entries stopped growing
+    for (size_t i = 0; i < block->entries.size(); ++i)
+    {
+        block->index[KeyOf(block->entries[i])] = i;
+    }
+    return block;
+}
+
+/*
+** override key in this environment, the last call for a key wins
+*/
+void Environment::set(const string & key, const string & value)
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    string entry = key + "=" + value;
+
+    mIsCached = false;
+    for (auto & o : mOverrides)
+    {
+        if (KeyOf(o) == key)
+        {
+            o = entry;
+            return ;
+        }
+    }
+    mOverrides.push_back(entry);
+}
+
+/*
+** NULL terminated, suitable for execve(). the array stays valid
+** as long as this environment is not modified.
+*/
+char *const *Environment::envp() const
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    if (!mIsCached)
+    {
+        materialise();
+    }
+    return const_cast<char *const *>(mEnvp.data());
+}
+
+std::vector<string> Environment::entries() const
+{
+    std::vector<string> out;
+
+    for (char *const *e = envp(); *e; ++e)
+    {
+        out.push_back(*e);
+    }
+    return out;
+}
+
+/*
+** base entries in order, overridden ones replaced in place,
+** followed by the overrides the base does not know about.
+** no string is copied: the array points into the two layers.
+*/
+void Environment::materialise() const
+{
+    mEnvp.clear();
+    mEnvp.reserve(mBase->entries.size() + mOverrides.size() + 1);
+    for (auto & e : mBase->entries)
+    {
+        mEnvp.push_back(e.c_str());
+    }
+    for (auto & o : mOverrides)
+    {
+        auto it = mBase->index.find(KeyOf(o));
+        if (it != mBase->index.end())
+        {
+            mEnvp[it->second] = o.c_str();
+        }
+        else
+        {
+            mEnvp.push_back(o.c_str());
+        }
+    }
+    mEnvp.push_back(NULL);
+    mIsCached = true;
+}
+
+const std::shared_ptr<const EnvironmentBlock> & Environment::getBase() const
+{
+    return mBase;
+}
+
+void Environment::setBase(std::shared_ptr<const EnvironmentBlock> newBase)
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    mBase = newBase;
+    mIsCached = false;
+}
+
+const std::vector<string> & Environment::getOverrides() const
+{
+    return mOverrides;
+}
+
+bool Environment::operator==(const Environment & other) const
+{
+    return mBase == other.mBase && mOverrides == other.mOverrides;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+
+/*
+** an interned set of KEY=VALUE entries, without duplicate keys.
+** the supervisor's own environment is interned once and shared
+** by every program.
+*/
+typedef struct EnvironmentBlock {
+    std::vector<string> entries;
+    // key -> position in entries, keys are views into entries
+    std::unordered_map<std::string_view, size_t> index;
+} EnvironmentBlock;
+
+/*
+** a program's environment: the shared base block plus its own overrides.
+** the envp array handed to execve() is only built when first asked for,
+** then cached until the base or the overrides change.
+*/
+class Environment {
+public:
+        /*
+        ** xtors
+        */
+        Environment();
+        Environment(std::shared_ptr<const EnvironmentBlock> base);
+        Environment(const Environment & other);
+        Environment & operator=(const Environment & other);
+        ~Environment();
+
+        static std::shared_ptr<const EnvironmentBlock> Intern(char *envp[]);
+
+        /*
+        ** business logic
+        */
+        void set(const string & key, const string & value);
+        char *const *envp() const;
+        std::vector<string> entries() const;
+
+        /*
+        ** get/setters
+        */
+        const std::shared_ptr<const EnvironmentBlock> & getBase() const;
+        void setBase(std::shared_ptr<const EnvironmentBlock> newBase);
+        const std::vector<string> & getOverrides() const;
+
+        bool operator==(const Environment & other) const;
+private:
+        /*
+        ** private functions
+        */
+        void materialise() const;
+
+        /*
+        ** class members
+        */
+        std::shared_ptr<const EnvironmentBlock> mBase;
+        // KEY=VALUE, one per key, in the order they were first set
+        std::vector<string> mOverrides;
+
+        // cache, points into mBase and mOverrides
+        mutable std::mutex mCacheMutex;
+        mutable bool mIsCached;
+        mutable std::vector<const char *> mEnvp;
+};
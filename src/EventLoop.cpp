@@ -0,0 +1,188 @@
+#include "EventLoop.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+EventLoop::EventLoop() :
+    mEpollFd(::epoll_create1(EPOLL_CLOEXEC)),
+    mWakeFd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    mIsRunning(false),
+    mIsStopRequested(false),
+    mNextTimerId(1)
+{
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = mWakeFd;
+    ::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev);
+}
+
+EventLoop::~EventLoop()
+{
+    ::close(mWakeFd);
+    ::close(mEpollFd);
+}
+
+int EventLoop::addFd(int fd, uint32_t events, FdCallback callback)
+{
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        return -1;
+    }
+    mCallbacks[fd] = std::make_shared<FdCallback>(std::move(callback));
+    return 0;
+}
+
+int EventLoop::modifyFd(int fd, uint32_t events)
+{
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    return ::epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void EventLoop::removeFd(int fd)
+{
+    ::epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, NULL);
+    mCallbacks.erase(fd);
+}
+
+EventLoop::TimerId EventLoop::addTimer(Clock::time_point deadline, Task task)
+{
+    TimerId id = mNextTimerId++;
+
+    mTimers.emplace(std::make_pair(deadline, id), std::move(task));
+    mTimerDeadlines[id] = deadline;
+    return id;
+}
+
+void EventLoop::cancelTimer(TimerId id)
+{
+    auto it = mTimerDeadlines.find(id);
+
+    if (it == mTimerDeadlines.end())
+    {
+        return ;
+    }
+    mTimers.erase(std::make_pair(it->second, id));
+    mTimerDeadlines.erase(it);
+}
+
+void EventLoop::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mTaskMutex);
+        mTasks.push_back(std::move(task));
+    }
+    wake();
+}
+
+/*
+** tasks posted before stop() still run
+*/
+void EventLoop::stop()
+{
+    mIsStopRequested = true;
+    wake();
+}
+
+void EventLoop::run()
+{
+    struct epoll_event events[64];
+
+    mThreadId = std::this_thread::get_id();
+    mIsRunning = true;
+    while (!mIsStopRequested)
+    {
+        int n = ::epoll_wait(mEpollFd, events, 64, getTimeout());
+        if (n == -1 && errno != EINTR)
+        {
+            break;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            int fd = events[i].data.fd;
+            if (fd == mWakeFd)
+            {
+                uint64_t value;
+                while (::read(mWakeFd, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+            // keep the callback alive even if it removes its own fd
+            auto it = mCallbacks.find(fd);
+            if (it == mCallbacks.end())
+            {
+                continue;
+            }
+            auto callback = it->second;
+            (*callback)(events[i].events);
+        }
+        runDueTimers();
+        runPostedTasks();
+    }
+    runPostedTasks();
+    mIsRunning = false;
+}
+
+bool EventLoop::isRunning() const
+{
+    return mIsRunning;
+}
+
+bool EventLoop::isLoopThread() const
+{
+    return std::this_thread::get_id() == mThreadId;
+}
+
+void EventLoop::wake()
+{
+    uint64_t one = 1;
+    IGNORE(::write(mWakeFd, &one, sizeof(one)))
+}
+
+void EventLoop::runPostedTasks()
+{
+    std::vector<Task> tasks;
+
+    {
+        std::lock_guard<std::mutex> lock(mTaskMutex);
+        tasks.swap(mTasks);
+    }
+    for (auto & task : tasks)
+    {
+        task();
+    }
+}
+
+/*
+** a timer may add or cancel timers: each one is taken out before it runs
+*/
+void EventLoop::runDueTimers()
+{
+    Clock::time_point now = Clock::now();
+
+    while (!mTimers.empty() && mTimers.begin()->first.first <= now)
+    {
+        auto it = mTimers.begin();
+        Task task = std::move(it->second);
+        mTimerDeadlines.erase(it->first.second);
+        mTimers.erase(it);
+        task();
+    }
+}
+
+int EventLoop::getTimeout() const
+{
+    if (mTimers.empty())
+    {
+        return -1;
+    }
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(mTimers.begin()->first.first - Clock::now());
+    return std::max(0, (int)left.count());
+}
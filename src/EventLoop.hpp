@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+** a single threaded epoll loop. fds are watched with a callback, other threads
+** hand work to the loop with post(). everything registered with the loop only
+** runs on the thread which called run().
+**
+** timers are one-shot, kept by deadline: epoll_wait sleeps until the earliest
+** one, so any number of them costs no thread and no fd.
+*/
+class EventLoop {
+public:
+        typedef std::function<void(uint32_t events)> FdCallback;
+        typedef std::function<void()> Task;
+        typedef std::chrono::steady_clock Clock;
+        typedef uint64_t TimerId;
+
+        /*
+        ** xtors
+        */
+        EventLoop();
+        ~EventLoop();
+
+        /*
+        ** business logic
+        */
+        int addFd(int fd, uint32_t events, FdCallback callback);
+        int modifyFd(int fd, uint32_t events);
+        void removeFd(int fd);
+        // the task runs once, at deadline or a bit later
+        TimerId addTimer(Clock::time_point deadline, Task task);
+        // a timer which already ran is ignored
+        void cancelTimer(TimerId id);
+
+        // thread safe
+        void post(Task task);
+        void stop();
+
+        void run();
+
+        /*
+        ** get/setters
+        */
+        bool isRunning() const;
+        bool isLoopThread() const;
+private:
+        /*
+        ** private functions
+        */
+        void wake();
+        void runPostedTasks();
+        void runDueTimers();
+        // for epoll_wait: until the earliest timer, -1 without one
+        int getTimeout() const;
+
+        /*
+        ** class members
+        */
+        int mEpollFd;
+        int mWakeFd;
+        std::atomic<bool> mIsRunning;
+        // may be set before run() is even called
+        std::atomic<bool> mIsStopRequested;
+        std::thread::id mThreadId;
+        std::unordered_map<int, std::shared_ptr<FdCallback> > mCallbacks;
+        std::mutex mTaskMutex;
+        std::vector<Task> mTasks;
+        // by deadline, then by id: timers with the same deadline run in order
+        std::map<std::pair<Clock::time_point, TimerId>, Task> mTimers;
+        std::unordered_map<TimerId, Clock::time_point> mTimerDeadlines;
+        TimerId mNextTimerId;
+};
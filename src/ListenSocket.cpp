@@ -0,0 +1,158 @@
+#include "ListenSocket.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/un.h>
+#include <unistd.h>
+
+ListenSocket::ListenSocket(const string & address, int fd) :
+    mAddress(address),
+    mFd(fd)
+{}
+
+ListenSocket::~ListenSocket()
+{
+    ::close(mFd);
+    if (mAddress.find('/') != string::npos)
+    {
+        ::unlink(mAddress.c_str());
+    }
+}
+
+std::shared_ptr<ListenSocket> ListenSocket::Open(const string & address)
+{
+    struct sockaddr_storage storage = {};
+    socklen_t size;
+
+    if (ParseAddress(address, storage, size) != 0)
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+    if (storage.ss_family == AF_UNIX)
+    {
+        ::unlink(address.c_str());
+    }
+    // blocking: the file description is shared with the children
+    int fd = ::socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        return nullptr;
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(fd, (struct sockaddr *)&storage, size) == -1 ||
+        ::listen(fd, SOMAXCONN) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        return nullptr;
+    }
+    return std::shared_ptr<ListenSocket>(new ListenSocket(address, fd));
+}
+
+int ListenSocket::ParseAddress(const string & address, struct sockaddr_storage & storage, socklen_t & size)
+{
+    storage = {};
+    if (address.find('/') != string::npos)
+    {
+        struct sockaddr_un *addr = (struct sockaddr_un *)&storage;
+        if (address.size() >= sizeof(addr->sun_path))
+        {
+            return 1;
+        }
+        addr->sun_family = AF_UNIX;
+        std::strncpy(addr->sun_path, address.c_str(), sizeof(addr->sun_path) - 1);
+        size = sizeof(*addr);
+        return 0;
+    }
+
+    struct sockaddr_in *addr = (struct sockaddr_in *)&storage;
+    size_t colon = address.rfind(':');
+    string host = (colon == string::npos) ? "127.0.0.1" : address.substr(0, colon);
+    string port_string = (colon == string::npos) ? address : address.substr(colon + 1);
+    char *end = nullptr;
+    long port = std::strtol(port_string.c_str(), &end, 10);
+    if (port_string.empty() || *end != '\0' || port <= 0 || port > 65535)
+    {
+        return 1;
+    }
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    if (host == "*")
+    {
+        addr->sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+    else if (::inet_pton(AF_INET, host.c_str(), &addr->sin_addr) != 1)
+    {
+        return 1;
+    }
+    size = sizeof(*addr);
+    return 0;
+}
+
+/*
+** read from /proc/net: unix sockets by path (accepted ones share the
+** address of the listener), tcp ones by local port
+*/
+size_t ListenSocket::countConnections() const
+{
+    struct sockaddr_storage storage = {};
+    socklen_t size = sizeof(storage);
+    size_t n = 0;
+    string line;
+
+    if (::getsockname(mFd, (struct sockaddr *)&storage, &size) == -1)
+    {
+        return 0;
+    }
+    if (storage.ss_family == AF_UNIX)
+    {
+        std::ifstream table("/proc/net/unix");
+        std::getline(table, line);
+        while (std::getline(table, line))
+        {
+            // Num RefCount Protocol Flags Type St Inode Path, 03 is connected
+            std::istringstream fields(line);
+            string num, references, protocol, flags, type, state, inode, path;
+            fields >> num >> references >> protocol >> flags >> type >> state >> inode >> path;
+            n += state == "03" && path == mAddress;
+        }
+        return n;
+    }
+    unsigned long port = ntohs((storage.ss_family == AF_INET) ?
+        ((struct sockaddr_in *)&storage)->sin_port :
+        ((struct sockaddr_in6 *)&storage)->sin6_port);
+    for (const char *path : {"/proc/net/tcp", "/proc/net/tcp6"})
+    {
+        std::ifstream table(path);
+        std::getline(table, line);
+        while (std::getline(table, line))
+        {
+            // sl local_address:port rem_address:port st, in hex. 01 is established
+            std::istringstream fields(line);
+            string number, local, remote, state;
+            fields >> number >> local >> remote >> state;
+            size_t colon = local.rfind(':');
+            n += state == "01" && colon != string::npos &&
+                std::strtoul(local.c_str() + colon + 1, nullptr, 16) == port;
+        }
+    }
+    return n;
+}
+
+int ListenSocket::getFd() const
+{
+    return mFd;
+}
+
+const string & ListenSocket::getAddress() const
+{
+    return mAddress;
+}
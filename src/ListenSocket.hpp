@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+
+using std::string;
+
+/*
+** a listening socket bound by the supervisor for a program (`sockets:`), and
+** handed to its processes at each start (socket activation, see
+** Process::start). the socket outlives the processes: connections queue up
+** in its backlog while a program restarts, none is refused.
+**
+** addresses are written like the metrics endpoint: a port (127.0.0.1),
+** host:port (*:port for any address) or the path of a unix socket.
+*/
+class ListenSocket {
+public:
+        /*
+        ** xtors
+        */
+        ~ListenSocket();
+
+        /*
+        ** business logic
+        */
+        // binds and listens, returns null and sets errno on failure
+        static std::shared_ptr<ListenSocket> Open(const string & address);
+        // returns 1 if the address is malformed
+        static int ParseAddress(const string & address, struct sockaddr_storage & storage, socklen_t & size);
+        // connections accepted from the socket and still open, 0 if unknown
+        size_t countConnections() const;
+
+        /*
+        ** get/setters
+        */
+        int getFd() const;
+        const string & getAddress() const;
+private:
+        ListenSocket(const string & address, int fd);
+
+        /*
+        ** class members
+        */
+        string mAddress;
+        int mFd;
+};
@@ -0,0 +1,238 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+
+namespace Metrics {
+
+size_t ShardIndex()
+{
+    static std::atomic<size_t> next_index(0);
+    static thread_local size_t index = next_index++ % Shards;
+
+    return index;
+}
+
+Counter::Counter()
+{
+    for (auto & shard : mShards)
+    {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Counter::inc(uint64_t n)
+{
+    mShards[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+
+    for (auto & shard : mShards)
+    {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Gauge::Gauge() :
+    mValue(0)
+{}
+
+void Gauge::set(int64_t v)
+{
+    mValue.store(v, std::memory_order_relaxed);
+}
+
+void Gauge::add(int64_t n)
+{
+    mValue.fetch_add(n, std::memory_order_relaxed);
+}
+
+int64_t Gauge::value() const
+{
+    return mValue.load(std::memory_order_relaxed);
+}
+
+Histogram::Histogram(const std::vector<double> & buckets) :
+    mBuckets(buckets)
+{
+    mBuckets.resize(std::min(mBuckets.size(), (size_t)MaxBuckets));
+    for (auto & shard : mShards)
+    {
+        for (auto & bucket : shard.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard.count.store(0, std::memory_order_relaxed);
+        shard.sumNanoseconds.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double seconds)
+{
+    Shard & shard = mShards[ShardIndex()];
+    // index of the first bucket the value fits in, the last one is +Inf
+    size_t bucket = std::lower_bound(mBuckets.begin(), mBuckets.end(), seconds) - mBuckets.begin();
+
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sumNanoseconds.fetch_add(std::max(seconds, 0.0) * 1e9, std::memory_order_relaxed);
+}
+
+void Histogram::render(std::ostream & out, const string & name) const
+{
+    uint64_t cumulative = 0, count = 0, sum = 0;
+
+    for (size_t i = 0; i <= mBuckets.size(); ++i)
+    {
+        for (auto & shard : mShards)
+        {
+            cumulative += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        out << name << "_bucket{le=\"";
+        if (i < mBuckets.size())
+        {
+            out << mBuckets[i];
+        }
+        else
+        {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << "\n";
+    }
+    for (auto & shard : mShards)
+    {
+        count += shard.count.load(std::memory_order_relaxed);
+        sum += shard.sumNanoseconds.load(std::memory_order_relaxed);
+    }
+    out << name << "_sum " << sum / 1e9 << "\n";
+    out << name << "_count " << count << "\n";
+}
+
+Family::Family(const string & label, const std::vector<string> & values) :
+    mLabel(label),
+    mValues(values),
+    mCounts(new std::atomic<int64_t>[values.size()])
+{
+    for (size_t i = 0; i < mValues.size(); ++i)
+    {
+        mCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Family::add(size_t index, int64_t n)
+{
+    if (index < mValues.size())
+    {
+        mCounts[index].fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+void Family::render(std::ostream & out, const string & name, bool skip_zeroes) const
+{
+    for (size_t i = 0; i < mValues.size(); ++i)
+    {
+        int64_t value = mCounts[i].load(std::memory_order_relaxed);
+        if (value == 0 && skip_zeroes)
+        {
+            continue;
+        }
+        out << name << "{" << mLabel << "=\"" << mValues[i] << "\"} " << value << "\n";
+    }
+}
+
+const std::vector<double> & LatencyBuckets()
+{
+    static const std::vector<double> buckets = {
+        0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30
+    };
+    return buckets;
+}
+};
+
+MetricsRegistry::MetricsRegistry() {}
+
+MetricsRegistry::~MetricsRegistry() {}
+
+Metrics::Counter * MetricsRegistry::counter(const string & name, const string & help)
+{
+    Entry & entry = add(name, help, "counter");
+    entry.counter = std::make_unique<Metrics::Counter>();
+    return entry.counter.get();
+}
+
+Metrics::Gauge * MetricsRegistry::gauge(const string & name, const string & help)
+{
+    Entry & entry = add(name, help, "gauge");
+    entry.gauge = std::make_unique<Metrics::Gauge>();
+    return entry.gauge.get();
+}
+
+Metrics::Histogram * MetricsRegistry::histogram(
+    const string & name,
+    const string & help,
+    const std::vector<double> & buckets)
+{
+    Entry & entry = add(name, help, "histogram");
+    entry.histogram = std::make_unique<Metrics::Histogram>(buckets);
+    return entry.histogram.get();
+}
+
+Metrics::Family * MetricsRegistry::family(
+    const string & name,
+    const string & help,
+    const string & type,
+    const string & label,
+    const std::vector<string> & values)
+{
+    Entry & entry = add(name, help, type);
+    entry.family = std::make_unique<Metrics::Family>(label, values);
+    return entry.family.get();
+}
+
+void MetricsRegistry::collector(const string & name, const string & help, const string & type, Collector collect)
+{
+    add(name, help, type).collect = collect;
+}
+
+void MetricsRegistry::render(std::ostream & out) const
+{
+    for (auto & entry : mEntries)
+    {
+        out << "# HELP " << entry->name << " " << entry->help << "\n";
+        out << "# TYPE " << entry->name << " " << entry->type << "\n";
+        if (entry->counter)
+        {
+            out << entry->name << " " << entry->counter->value() << "\n";
+        }
+        else if (entry->gauge)
+        {
+            out << entry->name << " " << entry->gauge->value() << "\n";
+        }
+        else if (entry->histogram)
+        {
+            entry->histogram->render(out, entry->name);
+        }
+        else if (entry->family)
+        {
+            // counters only show the label values which happened
+            entry->family->render(out, entry->name, entry->type == "counter");
+        }
+        else if (entry->collect)
+        {
+            out << entry->name << " " << entry->collect() << "\n";
+        }
+    }
+}
+
+MetricsRegistry::Entry & MetricsRegistry::add(const string & name, const string & help, const string & type)
+{
+    mEntries.push_back(std::make_unique<Entry>());
+    Entry & entry = *mEntries.back();
+    entry.name = name;
+    entry.help = help;
+    entry.type = type;
+    return entry;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using std::string;
+
+/*
+** numeric telemetry, exposed in the prometheus text format (see MetricsServer).
+** updating a metric never takes a lock: counters and histograms are split in
+** shards, each thread adds to its own (relaxed atomics, one cache line apart),
+** and a scrape sums the shards. rendering costs O(number of metrics).
+*/
+namespace Metrics {
+
+    const size_t Shards = 8;
+
+    // shard of the calling thread
+    size_t ShardIndex();
+
+    typedef struct alignas(64) PaddedCounter {
+        std::atomic<uint64_t> value;
+    } PaddedCounter;
+
+    class Counter {
+    public:
+            Counter();
+            void inc(uint64_t n = 1);
+            uint64_t value() const;
+    private:
+            PaddedCounter mShards[Shards];
+    };
+
+    class Gauge {
+    public:
+            Gauge();
+            void set(int64_t v);
+            void add(int64_t n);
+            int64_t value() const;
+    private:
+            std::atomic<int64_t> mValue;
+    };
+
+    /*
+    ** latencies in seconds; buckets are the prometheus `le` upper bounds
+    */
+    class Histogram {
+    public:
+            static const size_t MaxBuckets = 16;
+
+            explicit Histogram(const std::vector<double> & buckets);
+            void observe(double seconds);
+            void render(std::ostream & out, const string & name) const;
+    private:
+            typedef struct alignas(64) Shard {
+                std::atomic<uint64_t> buckets[MaxBuckets + 1];
+                std::atomic<uint64_t> count;
+                std::atomic<uint64_t> sumNanoseconds;
+            } Shard;
+
+            std::vector<double> mBuckets;
+            Shard mShards[Shards];
+    };
+
+    /*
+    ** one counter or gauge per value of a label known up front (eg: exit codes)
+    */
+    class Family {
+    public:
+            Family(const string & label, const std::vector<string> & values);
+            void add(size_t index, int64_t n = 1);
+            void render(std::ostream & out, const string & name, bool skip_zeroes) const;
+    private:
+            string mLabel;
+            std::vector<string> mValues;
+            std::unique_ptr<std::atomic<int64_t>[]> mCounts;
+    };
+
+    const std::vector<double> & LatencyBuckets();
+};
+
+class MetricsRegistry {
+public:
+        typedef std::function<double()> Collector;
+
+        /*
+        ** xtors
+        */
+        MetricsRegistry();
+        ~MetricsRegistry();
+
+        /*
+        ** business logic
+        ** metrics are created once, at startup. the returned pointers stay valid
+        ** as long as the registry.
+        */
+        Metrics::Counter * counter(const string & name, const string & help);
+        Metrics::Gauge * gauge(const string & name, const string & help);
+        Metrics::Histogram * histogram(const string & name, const string & help,
+            const std::vector<double> & buckets = Metrics::LatencyBuckets());
+        Metrics::Family * family(const string & name, const string & help, const string & type,
+            const string & label, const std::vector<string> & values);
+        // evaluated when scraped, on the scraping thread
+        void collector(const string & name, const string & help, const string & type, Collector collect);
+
+        void render(std::ostream & out) const;
+private:
+        typedef struct Entry {
+            string name;
+            string help;
+            string type;
+            std::unique_ptr<Metrics::Counter> counter;
+            std::unique_ptr<Metrics::Gauge> gauge;
+            std::unique_ptr<Metrics::Histogram> histogram;
+            std::unique_ptr<Metrics::Family> family;
+            Collector collect;
+        } Entry;
+
+        /*
+        ** private functions
+        */
+        Entry & add(const string & name, const string & help, const string & type);
+
+        /*
+        ** class members
+        */
+        std::vector<std::unique_ptr<Entry> > mEntries;
+};
@@ -0,0 +1,191 @@
+#include "ListenSocket.hpp"
+#include "MetricsServer.hpp"
+
+#include <cerrno>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+MetricsServer::MetricsServer(EventLoop & loop, const string & address, const MetricsRegistry & registry) :
+    mLoop(loop),
+    mAddress(address),
+    mRegistry(registry),
+    mIsUnixSocket(address.find('/') != string::npos),
+    mListenFd(-1)
+{}
+
+/*
+** the loop is expected to be stopped by now, fds are closed directly
+*/
+MetricsServer::~MetricsServer()
+{
+    for (auto & [fd, client] : mClients)
+    {
+        ::close(fd);
+    }
+    if (mListenFd != -1)
+    {
+        ::close(mListenFd);
+        if (mIsUnixSocket)
+        {
+            ::unlink(mAddress.c_str());
+        }
+    }
+}
+
+/*
+** returns -1 and sets errno on failure
+*/
+int MetricsServer::start()
+{
+    struct sockaddr_storage storage = {};
+    socklen_t size;
+
+    if (ListenSocket::ParseAddress(mAddress, storage, size) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (mIsUnixSocket)
+    {
+        ::unlink(mAddress.c_str());
+    }
+
+    mListenFd = ::socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mListenFd == -1)
+    {
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(mListenFd, (struct sockaddr *)&storage, size) == -1 ||
+        ::listen(mListenFd, SOMAXCONN) == -1)
+    {
+        int err = errno;
+        ::close(mListenFd);
+        mListenFd = -1;
+        errno = err;
+        return -1;
+    }
+    mLoop.post([this] {
+        mLoop.addFd(mListenFd, EPOLLIN, [this](uint32_t) { onAccept(); });
+    });
+    return 0;
+}
+
+const string & MetricsServer::getAddress() const
+{
+    return mAddress;
+}
+
+void MetricsServer::onAccept()
+{
+    for (;;)
+    {
+        int fd = ::accept4(mListenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1)
+        {
+            return ;
+        }
+        mClients[fd] = Client{"", ""};
+        mLoop.addFd(fd, EPOLLIN | EPOLLRDHUP, [this, fd](uint32_t events) {
+            onClientEvent(fd, events);
+        });
+    }
+}
+
+void MetricsServer::onClientEvent(int fd, uint32_t events)
+{
+    auto it = mClients.find(fd);
+    if (it == mClients.end())
+    {
+        return ;
+    }
+    Client & client = it->second;
+
+    if (events & EPOLLOUT)
+    {
+        flush(fd, client);
+        return ;
+    }
+    if (events & EPOLLIN)
+    {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            client.in.append(buffer, n);
+        }
+        bool is_closed = n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR);
+        // the headers are not needed, only the request line
+        if (client.out.empty() && client.in.find("\r\n\r\n") != string::npos)
+        {
+            client.out = respond(client.in);
+            flush(fd, client);
+            return ;
+        }
+        if (is_closed || client.in.size() > MaxRequestSize)
+        {
+            closeClient(fd);
+        }
+        return ;
+    }
+    if (events & (EPOLLHUP | EPOLLERR))
+    {
+        closeClient(fd);
+    }
+}
+
+string MetricsServer::respond(const string & request) const
+{
+    std::ostringstream body, response;
+    string request_line = request.substr(0, request.find("\r\n"));
+    bool is_found = request_line.rfind("GET /metrics ", 0) == 0 ||
+        request_line.rfind("GET / ", 0) == 0;
+
+    if (is_found)
+    {
+        mRegistry.render(body);
+    }
+    else
+    {
+        body << "not found: use GET /metrics\n";
+    }
+    response << "HTTP/1.0 " << ((is_found) ? "200 OK" : "404 Not Found") << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.str().size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body.str();
+    return response.str();
+}
+
+void MetricsServer::flush(int fd, Client & client)
+{
+    while (!client.out.empty())
+    {
+        ssize_t n = ::send(fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n == -1 && errno == EAGAIN)
+        {
+            mLoop.modifyFd(fd, EPOLLOUT | EPOLLRDHUP);
+            return ;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        client.out.erase(0, n);
+    }
+    closeClient(fd);
+}
+
+void MetricsServer::closeClient(int fd)
+{
+    mLoop.removeFd(fd);
+    mClients.erase(fd);
+    ::close(fd);
+}
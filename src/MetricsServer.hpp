@@ -0,0 +1,61 @@
+#pragma once
+
+#include "EventLoop.hpp"
+#include "Metrics.hpp"
+
+#include <unordered_map>
+
+using std::string;
+
+/*
+** answers HTTP requests for /metrics with the registry in prometheus text
+** format, on a loopback TCP port or a unix socket. requests are read, rendered
+** and answered on the event loop; the connection is closed once answered.
+*/
+class MetricsServer {
+public:
+        static const size_t MaxRequestSize = 8192;
+
+        /*
+        ** xtors
+        */
+        MetricsServer(EventLoop & loop, const string & address, const MetricsRegistry & registry);
+        ~MetricsServer();
+
+        /*
+        ** business logic
+        */
+        // address: a port (bound on 127.0.0.1), host:port or the path of a
+        //  unix socket, see ListenSocket::ParseAddress
+        int start();
+
+        /*
+        ** get/setters
+        */
+        const string & getAddress() const;
+private:
+        typedef struct Client {
+            string in;
+            string out;
+        } Client;
+
+        /*
+        ** private functions
+        */
+        void onAccept();
+        void onClientEvent(int fd, uint32_t events);
+        string respond(const string & request) const;
+        void flush(int fd, Client & client);
+        void closeClient(int fd);
+
+        /*
+        ** class members
+        */
+        EventLoop & mLoop;
+        string mAddress;
+        const MetricsRegistry & mRegistry;
+        bool mIsUnixSocket;
+        int mListenFd;
+        // only touched on the loop thread
+        std::unordered_map<int, Client> mClients;
+};
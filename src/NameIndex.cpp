@@ -0,0 +1,43 @@
+#include "NameIndex.hpp"
+
+NameIndex::NameIndex() {}
+
+NameIndex::~NameIndex() {}
+
+void NameIndex::insert(const string & name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    ++mNames[name];
+}
+
+void NameIndex::erase(const string & name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mNames.find(name);
+
+    if (it != mNames.end() && --it->second == 0)
+    {
+        mNames.erase(it);
+    }
+}
+
+void NameIndex::find(std::string_view prefix, std::vector<string> & out, size_t limit) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // names sharing a prefix are contiguous, starting at its lower bound
+    for (auto it = mNames.lower_bound(prefix);
+         it != mNames.end() && limit > 0 && std::string_view(it->first).substr(0, prefix.size()) == prefix;
+         ++it, --limit)
+    {
+        out.push_back(it->first);
+    }
+}
+
+size_t NameIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mNames.size();
+}
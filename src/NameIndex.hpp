@@ -0,0 +1,44 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+
+/*
+** program and process names in order, for prefix queries: completion in the
+** REPL and sorted listings. a query costs O(log n + k) for k names found.
+** a group and its first replica share a name: names are counted, and stay
+** until erased as many times as they were inserted.
+*/
+class NameIndex {
+public:
+        /*
+        ** xtors
+        */
+        NameIndex();
+        ~NameIndex();
+
+        /*
+        ** business logic
+        */
+        void insert(const string & name);
+        void erase(const string & name);
+        // appends the names starting with prefix to out, in order, at most limit
+        void find(std::string_view prefix, std::vector<string> & out, size_t limit = SIZE_MAX) const;
+
+        /*
+        ** get/setters
+        */
+        size_t size() const;
+private:
+        /*
+        ** class members
+        */
+        // completion reads from the REPL thread while commands reload
+        mutable std::mutex mMutex;
+        std::map<string, size_t, std::less<> > mNames;
+};
@@ -1,5 +1,7 @@
 #include "Process.hpp"
+#include "ProgramSchema.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -15,17 +17,43 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include <ctime>
-#include <linux/limits.h>
 
 #include "Utils.hpp"
 
+namespace {
+
+/*
+** async-signal-safe, for the child: no allocation
+*/
+static auto WriteNumber(char *out, long n) -> void
+{
+    char digits[24];
+    int i = 0;
+
+    do
+    {
+        digits[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    while (i > 0)
+    {
+        *out++ = digits[--i];
+    }
+    *out = '\0';
+}
+
+};
+
 int Process::start()
 {
     string cool;
     pid_t pid;
     int pipe_fds[2];
     int fork_pipes[2];
+    int ready_pipe[2] = {-1, -1};
     int count, err;
+    // a reload may swap the spec meanwhile: the child is built from one of them
+    const std::shared_ptr<const ProgramSpec> spec = getSpec();
 
     // pipe for stdout
     if (::pipe(pipe_fds) < 0)
@@ -37,12 +65,48 @@ int Process::start()
     if (::fcntl(fork_pipes[1], F_SETFD, fcntl(fork_pipes[1], F_GETFD) | FD_CLOEXEC) < 0)
     {return 1;}
 
+    // readiness notification: only the child is to hold the write end
+    closeReadyPipe();
+    if (spec->readyFd != -1 && ::pipe2(ready_pipe, O_CLOEXEC) < 0)
+    {return 1;}
+
+    // built (or taken from the spec's cache) before forking, shared by every replica
+    char *const *env_v = spec->environment.envp();
+
+    // socket activation: LISTEN_PID is only known in the child, which
+    //  writes it in place. nothing is allocated after fork
+    const auto & sockets = spec->listenSockets;
+    int n_sockets = sockets.size();
+    std::vector<char *> listen_env;
+    std::vector<int> moved_fds(n_sockets);
+    string listen_fds = "LISTEN_FDS=" + std::to_string(n_sockets);
+    char listen_pid[40] = "LISTEN_PID=";
+    if (n_sockets > 0)
+    {
+        for (char *const *var = env_v; *var != nullptr; ++var)
+        {
+            if (std::strncmp(*var, "LISTEN_", 7) != 0)
+            {
+                listen_env.push_back(*var);
+            }
+        }
+        listen_env.push_back(listen_fds.data());
+        listen_env.push_back(listen_pid);
+        listen_env.push_back(nullptr);
+        env_v = listen_env.data();
+    }
+
+    // argv too: a promotion may rename the process meanwhile, and malloc's
+    //  lock may be held by another thread when fork() copies it
+    string name = getProcessName();
+    std::vector<const char*> arg_v = Utils::ContainerToConstChar(name, spec->commandArguments);
+
     // this is a bridge
     if ((pid = ::fork()) < 0)
     {return 1;}
     if (pid == 0)
     {
-        mode_t mask = getUmask();
+        mode_t mask = spec->umask;
         if ((int)mask != -1)
         {
             ::umask(mask);
@@ -50,10 +114,10 @@ int Process::start()
 
         // output redirection
         int fd = STDOUT_FILENO;
-        if (getRedirectStreams())
+        if (spec->redirectStreams)
         {
             // if umask() was called, open() is affected.
-            fd = ::open(getOutputRedirectPath().c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+            fd = ::open(spec->outputRedirectPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
             if (fd == -1)
             {
                 ::write(fork_pipes[1], &errno, sizeof(int));
@@ -71,24 +135,54 @@ int Process::start()
         ::close(pipe_fds[0]);
         ::close(pipe_fds[1]);
         ::close(fork_pipes[0]);
-        if (getWorkingDir() != "")
+        if (spec->workingDir != "")
         {
-            if (::chdir(getWorkingDir().c_str()) < 0)
+            if (::chdir(spec->workingDir.c_str()) < 0)
             {
                 ::write(fork_pipes[1], &errno, sizeof(int));
                 ::exit(1);
             }
         }
 
-        std::vector<const char*> arg_v =
-            Utils::ContainerToConstChar(mProcessName, getCommandArguments());
-        std::vector<const char*> env_v =
-            Utils::ContainerToConstChar("", getAdditionalEnv());
+        if (n_sockets > 0 || ready_pipe[1] != -1)
+        {
+            // sockets go to 3, 4..., the ready pipe to ready_fd: everything
+            //  is first moved above them so that no dup2 overwrites a fd
+            //  still to be moved. the copies are closed by execve
+            int top = std::max(3 + n_sockets, spec->readyFd + 1);
+            int moved_ready = -1;
+            bool failed = (fork_pipes[1] = ::fcntl(fork_pipes[1], F_DUPFD_CLOEXEC, top)) == -1;
+            for (int i = 0; i < n_sockets; ++i)
+            {
+                moved_fds[i] = ::fcntl(sockets[i]->getFd(), F_DUPFD_CLOEXEC, top);
+                failed = failed || moved_fds[i] == -1;
+            }
+            if (ready_pipe[1] != -1)
+            {
+                moved_ready = ::fcntl(ready_pipe[1], F_DUPFD_CLOEXEC, top);
+                failed = failed || moved_ready == -1;
+            }
+            for (int i = 0; i < n_sockets && !failed; ++i)
+            {
+                failed = ::dup2(moved_fds[i], 3 + i) == -1;
+            }
+            if (moved_ready != -1 && !failed)
+            {
+                failed = ::dup2(moved_ready, spec->readyFd) == -1;
+            }
+            if (failed)
+            {
+                ::write(fork_pipes[1], &errno, sizeof(int));
+                ::exit(1);
+            }
+            WriteNumber(listen_pid + sizeof("LISTEN_PID=") - 1, ::getpid());
+        }
+
         int exec_return =
             ::execve(
-                mFullPath.c_str(),
+                spec->fullPath.c_str(),
                 const_cast<char*const*>(arg_v.data()),
-                const_cast<char*const*>(env_v.data()));
+                env_v);
         // execv error: write errno to the pipe opened in the parent process
         ::write(fork_pipes[1], &errno, sizeof(int));
         ::exit(exec_return);
@@ -103,33 +197,46 @@ int Process::start()
 
         ::close(fork_pipes[0]);
         ::close(pipe_fds[1]);
+        if (ready_pipe[1] != -1)
+        {
+            ::close(ready_pipe[1]);
+        }
+        mReadyPipe = ready_pipe[0];
+        mReadyLatency = -1.0;
+        // the child is reaped by the monitor even if execve failed
+        setPid(pid);
         if (count)
         {
+            closeReadyPipe();
             setStrerror(std::strerror(err));
             setIsAlive(false);
             return -1;
         }
 
         setExecTime(std::time(nullptr));
-        setPid(pid);
+        {
+            std::lock_guard<std::mutex> lock(mExitMutex);
+            mStartInstant = std::chrono::steady_clock::now();
+        }
         setIsAlive(true);
     }
     return getReturnValue();
 }
 
+/*
+** send the kill signal. the process stays alive until its monitor reaps it,
+** see waitForExit(). a held spare is continued to get the signal.
+*/
 int Process::stop()
 {
-    int ret = 0;
-
     if (!isAlive())
     {
         return -1;
     }
-    else
+    int ret = (::kill(mPid, getKillSignal()) == 0) ? 0 : 1;
+    if (mIsSpare)
     {
-        ret = ::kill(mPid, mKillSignal);
-        setIsAlive(ret == 0);
-        return (ret == 0) ? 0 : 1;
+        ::kill(mPid, SIGCONT);
     }
     return ret;
 }
@@ -140,136 +247,147 @@ int Process::kill()
     {
         return -1;
     }
-    else
+    ::kill(mPid, SIGKILL);
+    return 0;
+}
+
+/*
+** returns false if the process is still alive at deadline
+*/
+bool Process::waitForExit(std::chrono::steady_clock::time_point deadline) const
+{
+    std::unique_lock<std::mutex> lock(mExitMutex);
+    return mExitCondition.wait_until(lock, deadline, [this] { return !mIsAlive; });
+}
+
+void Process::waitForExit() const
+{
+    std::unique_lock<std::mutex> lock(mExitMutex);
+    mExitCondition.wait(lock, [this] { return !mIsAlive; });
+}
+
+/*
+** a new run supersedes the previous one, whose monitor then stops restarting.
+** 0 if the process is alive: checked under the lock start() holds, so two
+** concurrent starts can't both fork it.
+*/
+uint64_t Process::beginRun()
+{
+    std::lock_guard<std::mutex> lock(mRunMutex);
+    if (isAlive())
     {
-        ::kill(mPid, SIGKILL);
-        setIsAlive(false);
+        return 0;
     }
-    return 0;
+    return ++mRun;
 }
 
-std::ostream & operator<<(std::ostream & s, const Process & src)
+/*
+** start the process, unless run is not current anymore. a stop either
+** comes before the start and cancels it, or finds the process alive.
+*/
+bool Process::startRun(uint64_t run)
 {
-    string out;
-    string working_dir = src.getWorkingDir();
-    if (working_dir.empty())
+    std::lock_guard<std::mutex> lock(mRunMutex);
+    if (mRun != run)
     {
-        char path[PATH_MAX];
-        getcwd(path, PATH_MAX);
-        working_dir = path;
+        return false;
     }
-    string rets;
-    const std::vector<int>& ret_vals = src.getExpectedReturnValues();
-    bool add_comma = ret_vals.size() != 1;
-    for (auto it = ret_vals.begin(); it != ret_vals.end(); ++it)
+    start();
+    return true;
+}
+
+void Process::endRun()
+{
+    std::lock_guard<std::mutex> lock(mRunMutex);
+    ++mRun;
+}
+
+/*
+** same as startRun: a stop either comes first, or finds the process held
+** and continues it (see stop())
+*/
+bool Process::hold(uint64_t run)
+{
+    std::lock_guard<std::mutex> lock(mRunMutex);
+    if (mRun != run || !isAlive())
     {
-        rets += std::to_string(*it);
-        if (add_comma)
-        {
-            rets += ", ";
-        }
+        return false;
     }
-    if (src.getCommandArguments().size() != 0)
+    return ::kill(mPid, SIGSTOP) == 0;
+}
+
+void Process::resume()
+{
+    if (isAlive())
     {
-        out = Utils::JoinStrings(src.getCommandArguments(), ", ");
+        ::kill(mPid, SIGCONT);
     }
+}
+
+std::ostream & operator<<(std::ostream & s, const Process & src)
+{
     s << "[" << src.getProcessName() << "]"
       << "\n\trunning: " << ((src.isAlive()) ? "true, PID: " + std::to_string(src.getPid()) : "false")
-      << "\n\tfull_path: " << src.getFullPath()
-      << "\n\tstart_command: [" << out << "]"
-      << "\n\tlog_to_file: " << ((src.getRedirectStreams()) ? "[" + src.getOutputRedirectPath() + "]" : "false")
-      << "\n\tworking_dir: " << "\"" << working_dir << "\""
-      << "\n\tvalid return values: " << "[" << rets << "]"
-      << "\n";
+      << "\n\tstate: " << ProcessStateName(src.getState());
+    ProgramSchema::Print(s, *src.getSpec());
+    s << "\n";
     return s;
 }
 
 Process::Process() :
+    mSpec(std::make_shared<const ProgramSpec>()),
     mIsAlive(false),
-    mExecOnStartup(false),
-    mRedirectStreams(true),
-    mExpectedReturnValues(std::vector<int>()),
     mReturnValue(-1),
-    mNumberOfRestarts(0),
     mPid(0),
-    mKillSignal(SIGTERM),
-    mForceQuitWaitTime(0.0),
-    mUmask(-1),
-    mShouldRestart(ShouldRestart::Never),
-    mStartTime(0.00),
     mExecTime(0.00),
-    mFullPath(""),
-    mProcessName(""),
-    mWorkingDir(""),
-    mOutputStreamRedirectPath(""),
-    mCommandArguments(std::vector<string>()),
-    mAdditionalEnv(std::vector<string>())
+    mStrerror(""),
+    mProcessName(std::make_shared<const string>()),
+    mState(ProcessState::Stopped),
+    mRestarts(0),
+    mLastSignal(0),
+    mExitWallTime(0.0),
+    mUsage(),
+    mStatusSlot(-1),
+    mReadyPipe(-1),
+    mReadyLatency(-1.0),
+    mIsSpare(false),
+    mRun(0)
 {}
 
-Process::Process(const Process & process)
-{
-    mIsAlive = process.mIsAlive;
-    mExecOnStartup = process.mExecOnStartup;
-    mRedirectStreams = process.mRedirectStreams;
-    mExpectedReturnValues = process.mExpectedReturnValues;
-    mReturnValue = 0;
-    mNumberOfRestarts = process.mNumberOfRestarts;
-    mPid = process.mPid;
-    mKillSignal = process.mKillSignal;
-    mForceQuitWaitTime = process.mForceQuitWaitTime;
-    mUmask = process.mUmask;
-    mShouldRestart = process.mShouldRestart;
-    mStartTime =  0.0;
-    mExecTime = 0.0;
-    mFullPath = process.mFullPath;
-    mProcessName = process.mProcessName;
-    mWorkingDir = process.mWorkingDir;
-    mAdditionalEnv = process.mAdditionalEnv;
-    mOutputStreamRedirectPath = process.mOutputStreamRedirectPath;
-    mCommandArguments = process.mCommandArguments;
-}
-
-Process::Process(
-        bool isAlive,
-        bool execOnStartup,
-        bool hasStandardStreams,
-        std::vector<int> expectedReturnValues,
-        int returnValue,
-        int numberOfRestarts,
-        int numberOfProcesses,
-        int killSignal,
-        double forceQuitWaitTime,
-        int umask,
-        ShouldRestart shouldRestart,
-        const string &fullPath,
-        const string &name,
-        const string &workingDir,
-        const string &outputRedirectPath,
-        const std::vector<string> &commandArgs,
-        const std::vector<string> &additionalEnv) :
-    mIsAlive(isAlive),
-    mExecOnStartup(execOnStartup),
-    mRedirectStreams(hasStandardStreams),
-    mExpectedReturnValues(expectedReturnValues),
-    mReturnValue(returnValue),
-    mNumberOfRestarts(numberOfRestarts),
-    mNumberOfProcesses(numberOfProcesses),
+Process::Process(std::shared_ptr<const ProgramSpec> spec, const string &processName) :
+    mSpec(spec),
+    mIsAlive(false),
+    mReturnValue(-1),
     mPid(0),
-    mKillSignal(killSignal),
-    mForceQuitWaitTime(forceQuitWaitTime),
-    mUmask(umask),
-    mShouldRestart(shouldRestart),
-    mStartTime(0.0),
-    mExecTime(0.0),
-    mFullPath(fullPath),
-    mProcessName(name),
-    mWorkingDir(workingDir),
-    mOutputStreamRedirectPath(outputRedirectPath),
-    mCommandArguments(commandArgs),
-    mAdditionalEnv(additionalEnv)
+    mExecTime(0.00),
+    mStrerror(""),
+    mProcessName(std::make_shared<const string>(processName)),
+    mState(ProcessState::Stopped),
+    mRestarts(0),
+    mLastSignal(0),
+    mExitWallTime(0.0),
+    mUsage(),
+    mStatusSlot(-1),
+    mReadyPipe(-1),
+    mReadyLatency(-1.0),
+    mIsSpare(false),
+    mRun(0)
 {}
 
-Process::~Process() {}
+Process::~Process()
+{
+    closeReadyPipe();
+}
+
+std::shared_ptr<const ProgramSpec> Process::getSpec() const
+{
+    return mSpec.load();
+}
+
+void Process::setSpec(std::shared_ptr<const ProgramSpec> newSpec)
+{
+    mSpec.store(std::move(newSpec));
+}
 
 bool Process::isAlive() const
 {
@@ -278,235 +396,251 @@ bool Process::isAlive() const
 
 void Process::setIsAlive(bool newIsAlive)
 {
-    mIsAlive = newIsAlive;
+    {
+        std::lock_guard<std::mutex> lock(mExitMutex);
+        if (mIsAlive && !newIsAlive)
+        {
+            mExitTime = std::chrono::steady_clock::now();
+        }
+        mIsAlive = newIsAlive;
+    }
+    mExitCondition.notify_all();
+}
+
+int Process::getReturnValue() const
+{
+    return mReturnValue;
 }
 
-ShouldRestart Process::getShouldRestart() const
+void Process::setReturnValue(int newReturnValue)
 {
-    return mShouldRestart;
+    mReturnValue = newReturnValue;
 }
 
-void Process::setShouldRestart(int newShouldRestart)
+int Process::getPid() const
 {
-    mShouldRestart = (ShouldRestart)newShouldRestart;
+    return mPid;
 }
 
-bool Process::getExecOnStartup() const
+void Process::setPid(int newPid)
 {
-    return mExecOnStartup;
+    mPid = newPid;
 }
 
-void Process::setExecOnStartup(bool newExecOnStartup)
+long double Process::getExecTime() const
 {
-    mExecOnStartup = newExecOnStartup;
+    return mExecTime;
 }
 
-bool Process::getRedirectStreams() const
+void Process::setExecTime(long double newExecTime)
 {
-    return mRedirectStreams;
+    mExecTime = newExecTime;
 }
 
-void Process::setRedirectStreams(bool newHasStandardStreams)
+const string &Process::getStrerror() const
 {
-    mRedirectStreams = newHasStandardStreams;
+    return mStrerror;
 }
 
-bool Process::isExpectedReturnValue(int ret_val) const
+void Process::setStrerror(const string &newStrerror)
 {
-    for (auto & r: mExpectedReturnValues)
-    {
-        if (r == ret_val)
-            return true;
-    }
-    return false;
+    mStrerror = newStrerror;
 }
 
-const std::vector<int>& Process::getExpectedReturnValues() const
+string Process::getProcessName() const
 {
-    return mExpectedReturnValues;
+    return *mProcessName.load();
 }
 
-// sets expected return values to newExpectedReturn,
-// returns true if the value changed, false if not.
-bool Process::setExpectedReturns(const std::vector<int>& newExpectedReturn)
+// for readers which keep a view of it
+std::shared_ptr<const string> Process::shareProcessName() const
 {
-    if (newExpectedReturn == mExpectedReturnValues)
-        return false;
-    mExpectedReturnValues.clear();
-    for (int v : newExpectedReturn)
-    {
-        mExpectedReturnValues.push_back(v);
-    }
-    return true;
+    return mProcessName.load();
 }
 
-int Process::getReturnValue() const
+void Process::setProcessName(const string &newProcessName)
 {
-    return mReturnValue;
+    mProcessName = std::make_shared<const string>(newProcessName);
 }
 
-void Process::setReturnValue(int newReturnValue)
+uint64_t Process::getRun() const
 {
-    mReturnValue = newReturnValue;
+    return mRun;
 }
 
-int Process::getNumberOfRestarts() const
+std::chrono::steady_clock::time_point Process::getExitTime() const
 {
-    return mNumberOfRestarts;
+    std::lock_guard<std::mutex> lock(mExitMutex);
+    return mExitTime;
 }
 
-void Process::setNumberOfRestarts(int newNumberOfRestarts)
+std::chrono::steady_clock::time_point Process::getStartInstant() const
 {
-    mNumberOfRestarts = newNumberOfRestarts;
+    std::lock_guard<std::mutex> lock(mExitMutex);
+    return mStartInstant;
 }
 
-int Process::getNumberOfProcesses() const
+ProcessState Process::getState() const
 {
-    return mNumberOfProcesses;
+    return (ProcessState)mState.load();
 }
 
-void Process::setNumberOfProcesses(int newNumberOfProcesses)
+void Process::setState(ProcessState newState)
 {
-    mNumberOfProcesses = newNumberOfProcesses;
+    mState = newState;
 }
 
-int Process::getPid() const
+int Process::getRestarts() const
 {
-    return mPid;
+    return mRestarts;
 }
 
-void Process::setPid(int newPid)
+void Process::setRestarts(int newRestarts)
 {
-    mPid = newPid;
+    mRestarts = newRestarts;
 }
 
-int Process::getKillSignal() const
+int Process::getLastSignal() const
 {
-    return mKillSignal;
+    return mLastSignal;
 }
 
-void Process::setKillSignal(int newKillSignal)
+void Process::setLastSignal(int newLastSignal)
 {
-    mKillSignal = newKillSignal;
+    mLastSignal = newLastSignal;
 }
 
-double Process::getForceQuitWaitTime() const
+long double Process::getExitWallTime() const
 {
-    return mForceQuitWaitTime;
+    return mExitWallTime;
 }
 
-void Process::setForceQuitWaitTime(double newForceQuitWaitTime)
+void Process::setExitWallTime(long double newExitWallTime)
 {
-    mForceQuitWaitTime = newForceQuitWaitTime;
+    mExitWallTime = newExitWallTime;
 }
 
-int Process::getUmask() const
+const struct rusage &Process::getUsage() const
 {
-    return mUmask;
+    return mUsage;
 }
 
-void Process::setUmask(int newUmask)
+void Process::setUsage(const struct rusage &newUsage)
 {
-    mUmask = newUmask;
+    mUsage = newUsage;
 }
 
-long double Process::getStartTime() const
+int Process::getReadyPipe() const
 {
-    return mStartTime;
+    return mReadyPipe;
 }
 
-void Process::setStartTime(long double newStartTime)
+void Process::closeReadyPipe()
 {
-    mStartTime = newStartTime;
+    if (mReadyPipe != -1)
+    {
+        ::close(mReadyPipe);
+        mReadyPipe = -1;
+    }
 }
 
-long double Process::getExecTime() const
+double Process::getReadyLatency() const
 {
-    return mExecTime;
+    return mReadyLatency;
 }
 
-void Process::setExecTime(long double newExecTime)
+void Process::setReadyLatency(double newReadyLatency)
 {
-    mExecTime = newExecTime;
+    mReadyLatency = newReadyLatency;
 }
 
-const string &Process::getStrerror() const
+int Process::getStatusSlot() const
 {
-    return mFullPath;
+    return mStatusSlot;
 }
 
-void Process::setStrerror(const string &newStrerror)
+void Process::setStatusSlot(int newStatusSlot)
 {
-    mStrerror = newStrerror;
+    mStatusSlot = newStatusSlot;
+}
+
+bool Process::isSpare() const
+{
+    return mIsSpare;
 }
 
-const string &Process::getFullPath() const
+void Process::setIsSpare(bool newIsSpare)
 {
-    return mFullPath;
+    mIsSpare = newIsSpare;
 }
 
-void Process::setFullPath(const string &newFullPath)
+ShouldRestart Process::getShouldRestart() const
 {
-    mFullPath = newFullPath;
+    return getSpec()->shouldRestart;
 }
 
-const string &Process::getProcessName() const
+bool Process::getExecOnStartup() const
 {
-    return mProcessName;
+    return getSpec()->execOnStartup;
 }
 
-void Process::setProcessName(const string &newProcessName)
+bool Process::getRedirectStreams() const
 {
-    mProcessName = newProcessName;
+    return getSpec()->redirectStreams;
 }
 
-const string &Process::getWorkingDir() const
+bool Process::isExpectedReturnValue(int ret_val) const
 {
-    return mWorkingDir;
+    const auto spec = getSpec();
+    for (auto & r: spec->expectedReturnValues)
+    {
+        if (r == ret_val)
+            return true;
+    }
+    return false;
 }
 
-void Process::setWorkingDir(const string &newWorkingDir)
+std::vector<int> Process::getExpectedReturnValues() const
 {
-    mWorkingDir = newWorkingDir;
+    return getSpec()->expectedReturnValues;
 }
 
-const std::vector<string> &Process::getAdditionalEnv() const
+int Process::getNumberOfRestarts() const
 {
-    return mAdditionalEnv;
+    return getSpec()->numberOfRestarts;
 }
 
-void Process::addAdditionalEnvValue(const string &newAdditionalEnvValue)
+int Process::getNumberOfProcesses() const
 {
-    auto name = newAdditionalEnvValue.substr(0, newAdditionalEnvValue.find("="));
+    return getSpec()->numberOfProcesses;
+}
 
-    // replace value if an envvar with the same name already exists
-    for (auto& v: mAdditionalEnv)
-    {
-        if (name == v.substr(0, v.find("=")))
-        {
-            v = newAdditionalEnvValue;
-        }
-    }
-    mAdditionalEnv.push_back(newAdditionalEnvValue);
+int Process::getKillSignal() const
+{
+    return getSpec()->killSignal;
 }
 
-const string &Process::getOutputRedirectPath() const
+double Process::getForceQuitWaitTime() const
 {
-    return mOutputStreamRedirectPath;
+    return getSpec()->forceQuitWaitTime;
 }
 
-void Process::setOutputRedirectPath(const string &newOutputRedirectPath)
+int Process::getUmask() const
 {
-    mOutputStreamRedirectPath = newOutputRedirectPath;
+    return getSpec()->umask;
 }
 
-const std::vector<string> &Process::getCommandArguments() const
+long double Process::getStartTime() const
 {
-    return mCommandArguments;
+    return getSpec()->startTime;
 }
 
-void Process::appendCommandArgument(const string &newStartCommand)
+int Process::getReadyFd() const
 {
-    mCommandArguments.push_back(newStartCommand);
+    return getSpec()->readyFd;
 }
 
+double Process::getReadyTimeout() const
+{
+    return getSpec()->readyTimeout;
+}
@@ -1,41 +1,27 @@
 #pragma once
 
+#include "ProcessState.hpp"
+#include "ProgramSpec.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sys/resource.h>
 #include <vector>
 
 using std::string;
 
-typedef enum ShouldRestart {
-    Never,
-    UnexpectedExit,
-    Always
-} ShouldRestart;
-
 class Process {
 public:
         /*
         ** xtors
         */
         Process();
-        Process(const Process & process);
-        Process(
-            bool isAlive,
-            bool execOnStartup,
-            bool hasStandardStreams,
-            std::vector<int> expectedReturn,
-            int returnValue,
-            int numberOfRestarts,
-            int numberOfProcesses,
-            int killSignal,
-            double forceQuitWaitTime,
-            int umask,
-            ShouldRestart shouldRestart,
-            const string &fullPath,
-            const string &processName,
-            const string &workingDir,
-            const string &outputRedirectPath,
-            const std::vector<string> &commandArgs,
-            const std::vector<string> &additionalEnv);
+        Process(std::shared_ptr<const ProgramSpec> spec, const string &processName);
         ~Process();
 
         /*
@@ -44,53 +30,75 @@ public:
         int start();
         int stop();
         int kill();
+        bool waitForExit(std::chrono::steady_clock::time_point deadline) const;
+        void waitForExit() const;
+        uint64_t beginRun();
+        bool startRun(uint64_t run);
+        void endRun();
+        // a warm spare is held stopped (SIGSTOP) until it is promoted
+        bool hold(uint64_t run);
+        void resume();
 
         /*
         ** get/setters
         */
+        std::shared_ptr<const ProgramSpec> getSpec() const;
+        void setSpec(std::shared_ptr<const ProgramSpec> newSpec);
         bool isAlive() const;
         void setIsAlive(bool newIsAlive);
-        bool getExecOnStartup() const;
-        void setExecOnStartup(bool newExecOnStartup);
-        bool getRedirectStreams() const;
-        void setRedirectStreams(bool newHasStandardStreams);
         int  getReturnValue() const;
         void setReturnValue(int newReturnValue);
+        int  getPid() const;
+        void setPid(int newPid);
+        long double getExecTime() const;
+        void setExecTime(long double newExecTime);
+        const string &getStrerror() const;
+        void setStrerror(const string &newStrerror);
+        string getProcessName() const;
+        std::shared_ptr<const string> shareProcessName() const;
+        void setProcessName(const string &newProcessName);
+        uint64_t getRun() const;
+        std::chrono::steady_clock::time_point getExitTime() const;
+        // when the last successful execve returned
+        std::chrono::steady_clock::time_point getStartInstant() const;
+        ProcessState getState() const;
+        void setState(ProcessState newState);
+        int  getRestarts() const;
+        void setRestarts(int newRestarts);
+        int  getLastSignal() const;
+        void setLastSignal(int newLastSignal);
+        long double getExitWallTime() const;
+        void setExitWallTime(long double newExitWallTime);
+        const struct rusage &getUsage() const;
+        void setUsage(const struct rusage &newUsage);
+        // read end of the ready_fd pipe, -1 if none. only used by the thread
+        //  which starts and monitors the process
+        int  getReadyPipe() const;
+        void closeReadyPipe();
+        // seconds from execve to READY, -1 until then
+        double getReadyLatency() const;
+        void setReadyLatency(double newReadyLatency);
+        int  getStatusSlot() const;
+        void setStatusSlot(int newStatusSlot);
+        bool isSpare() const;
+        void setIsSpare(bool newIsSpare);
+
+        /*
+        ** read from the shared spec
+        */
+        bool getExecOnStartup() const;
+        bool getRedirectStreams() const;
         bool isExpectedReturnValue(int ret_val) const;
-        const std::vector<int>& getExpectedReturnValues() const;
-        bool setExpectedReturns(const std::vector<int>& newExpectedReturn);
+        std::vector<int> getExpectedReturnValues() const;
         int  getNumberOfRestarts() const;
-        void setNumberOfRestarts(int newNumberOfRestarts);
         int  getNumberOfProcesses() const;
-        void setNumberOfProcesses(int newNumberOfProcesses);
-        int  getPid() const;
-        void setPid(int newPid);
         int  getKillSignal() const;
-        void setKillSignal(int killSignal);
         double getForceQuitWaitTime() const;
-        void setForceQuitWaitTime(double forceQuitWaitTime);
         int  getUmask() const;
-        void setUmask(int umask);
         ShouldRestart getShouldRestart() const;
-        void setShouldRestart(int newShouldRestart);
         long double getStartTime() const;
-        void setStartTime(long double newStartTime);
-        long double getExecTime() const;
-        void setExecTime(long double newExecTime);
-        const string &getFullPath() const;
-        void setFullPath(const string &newFullPath);
-        const string &getStrerror() const;
-        void setStrerror(const string &newStrerror);
-        const string &getProcessName() const;
-        void setProcessName(const string &newProcessName);
-        const string &getWorkingDir() const;
-        void setWorkingDir(const string &newWorkingDir);
-        const string &getOutputRedirectPath() const;
-        void setOutputRedirectPath(const string &newOutputRedirectPath);
-        const std::vector<string> &getCommandArguments() const;
-        void appendCommandArgument(const string &newStartCommand);
-        const std::vector<string> &getAdditionalEnv() const;
-        void addAdditionalEnvValue(const string &newAdditionalEnv);
+        int  getReadyFd() const;
+        double getReadyTimeout() const;
 private:
         /*
         ** private functions
@@ -99,27 +107,39 @@ private:
         /*
         ** class members
         */
-        bool mIsAlive;
-        bool mExecOnStartup;
-        bool mRedirectStreams;
-        std::vector<int> mExpectedReturnValues;
+        // swapped by a reload while the process' threads read it
+        std::atomic<std::shared_ptr<const ProgramSpec> > mSpec;
+
+        // per-instance runtime state
+        std::atomic<bool> mIsAlive;
         int mReturnValue;
-        int mNumberOfRestarts;
-        int mNumberOfProcesses;
         int mPid;
-        int mKillSignal;
-        double mForceQuitWaitTime;
-        int mUmask;
-        ShouldRestart mShouldRestart;
-        long double mStartTime;
         long double mExecTime;
         string mStrerror;
-        string mFullPath;
-        string mProcessName;
-        string mWorkingDir;
-        string mOutputStreamRedirectPath;
-        std::vector<string> mCommandArguments;
-        std::vector<string> mAdditionalEnv;
+        // swapped with a spare's by Supervisor::promoteSpare, while the
+        //  threads of both read them
+        std::atomic<std::shared_ptr<const string> > mProcessName;
+        std::atomic<int> mState;
+        int mRestarts;
+        int mLastSignal;
+        long double mExitWallTime;
+        struct rusage mUsage;
+        // entry in the status table, -1 if none
+        std::atomic<int> mStatusSlot;
+        int mReadyPipe;
+        std::atomic<double> mReadyLatency;
+        // started as a warm spare of its group, see Supervisor::promoteSpare
+        std::atomic<bool> mIsSpare;
+
+        // signaled when the monitor reaps the process
+        mutable std::mutex mExitMutex;
+        mutable std::condition_variable mExitCondition;
+        std::chrono::steady_clock::time_point mExitTime;
+        std::chrono::steady_clock::time_point mStartInstant;
+        // bumped by each start and stop: a monitor thread only restarts
+        // the process while the run it was started for is still current
+        std::mutex mRunMutex;
+        std::atomic<uint64_t> mRun;
 };
 
 std::ostream & operator<<(std::ostream & s, const Process & src);
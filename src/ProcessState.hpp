@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+** lifecycle of a supervised process:
+**   STOPPED -> STARTING -> RUNNING -> READY -> EXITED (-> BACKOFF -> STARTING ...)
+** READY once the program said so on its ready_fd, or after start_time.
+** FATAL once it failed and no restart is left, STOPPING while a stop
+** request waits for the process to exit. a warm spare goes READY -> SPARE,
+** held stopped until it replaces a replica which died (see warm_spares).
+** values are published in the status table, only append to this list.
+*/
+typedef enum ProcessState {
+    Stopped,
+    Starting,
+    Running,
+    Backoff,
+    Exited,
+    Fatal,
+    Stopping,
+    Ready,
+    Spare,
+    NumberOfStates
+} ProcessState;
+
+inline const char * ProcessStateName(int state)
+{
+    static const char * names[] = {
+        "STOPPED", "STARTING", "RUNNING", "BACKOFF", "EXITED", "FATAL", "STOPPING", "READY", "SPARE"
+    };
+    return (state >= 0 && state < NumberOfStates) ? names[state] : "UNKNOWN";
+}
@@ -0,0 +1,494 @@
+#include "ProgramSchema.hpp"
+#include "Schedule.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <functional>
+#include <tuple>
+
+// anonymous namespace
+namespace {
+
+enum FieldFlags : unsigned {
+    None = 0,
+    // the program is skipped if the key is missing
+    Required = 1 << 0,
+    // changing the value on reload restarts the program
+    Restart = 1 << 1,
+};
+
+/*
+** describes one config key: where it is stored in ProgramSpec, how it behaves,
+** an optional value check (returns an error message, or NULL if the value is fine)
+** and an optional decoder for keys which are not read with YAML::Node::as<T>()
+*/
+template <typename T>
+struct Field {
+    std::string_view name;
+    T ProgramSpec::* member;
+    unsigned flags = None;
+    const char *(*check)(const T &) = nullptr;
+    void (*decode)(const YAML::Node &, T &) = nullptr;
+};
+
+/*
+** the field table. order is the order of the status dump.
+*/
+constexpr auto Fields = std::make_tuple(
+    Field<string>{
+        .name = "name",
+        .member = &ProgramSpec::name,
+        .flags = Required,
+        .check = [](const string & v) -> const char * { return v.empty() ? "is empty" : nullptr; }},
+    Field<string>{
+        .name = "full_path",
+        .member = &ProgramSpec::fullPath,
+        .flags = Required | Restart,
+        .check = [](const string & v) -> const char * { return v.empty() ? "is empty" : nullptr; }},
+    Field<std::vector<string> >{
+        .name = "start_command",
+        .member = &ProgramSpec::commandArguments},
+    Field<std::vector<int> >{
+        .name = "expected_return",
+        .member = &ProgramSpec::expectedReturnValues,
+        .flags = Required | Restart,
+        .check = [](const std::vector<int> & v) -> const char * {
+            if (v.empty())
+            {return "no value set";}
+            return std::all_of(v.begin(), v.end(), [](int r) { return r >= 0 && r <= 255; }) ?
+                nullptr : "must be between 0 and 255";
+        }},
+    Field<int>{
+        .name = "number_of_processes",
+        .member = &ProgramSpec::numberOfProcesses,
+        .check = [](const int & v) -> const char * { return (v < 1) ? "must be at least 1" : nullptr; }},
+    Field<int>{
+        .name = "warm_spares",
+        .member = &ProgramSpec::warmSpares,
+        .check = [](const int & v) -> const char * { return (v < 0) ? "must be positive" : nullptr; }},
+    Field<bool>{
+        .name = "exec_on_startup",
+        .member = &ProgramSpec::execOnStartup},
+    Field<ShouldRestart>{
+        .name = "should_restart",
+        .member = &ProgramSpec::shouldRestart,
+        .check = [](const ShouldRestart & v) -> const char * {
+            return (v < ShouldRestart::Never || v > ShouldRestart::Always) ?
+                "must be 0 (never), 1 (unexpected exit) or 2 (always)" : nullptr;
+        }},
+    Field<int>{
+        .name = "number_of_restarts",
+        .member = &ProgramSpec::numberOfRestarts,
+        .flags = Restart,
+        .check = [](const int & v) -> const char * { return (v < 0) ? "must be positive" : nullptr; }},
+    Field<long double>{
+        .name = "start_time",
+        .member = &ProgramSpec::startTime,
+        .check = [](const long double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<int>{
+        .name = "ready_fd",
+        .member = &ProgramSpec::readyFd,
+        .flags = Restart,
+        .check = [](const int & v) -> const char * {
+            return (v != -1 && v < 3) ? "must be 3 or more (0, 1 and 2 are the standard streams)" : nullptr;
+        }},
+    Field<double>{
+        .name = "ready_timeout",
+        .member = &ProgramSpec::readyTimeout,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<int>{
+        .name = "kill_signal",
+        .member = &ProgramSpec::killSignal,
+        .check = [](const int & v) -> const char * { return (v <= 0 || v >= NSIG) ? "invalid signal" : nullptr; },
+        // either a number or a name ("SIGTERM", "TERM")
+        .decode = [](const YAML::Node & n, int & out) { out = Utils::SignalFromString(n.as<string>()); }},
+    Field<double>{
+        .name = "force_quit_wait_time",
+        .member = &ProgramSpec::forceQuitWaitTime,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<bool>{
+        .name = "redirect_streams",
+        .member = &ProgramSpec::redirectStreams},
+    Field<string>{
+        .name = "output_redirect_path",
+        .member = &ProgramSpec::outputRedirectPath},
+    Field<string>{
+        .name = "working_directory",
+        .member = &ProgramSpec::workingDir},
+    Field<int>{
+        .name = "umask",
+        .member = &ProgramSpec::umask,
+        .check = [](const int & v) -> const char * {
+            return (v != -1 && (v < 0 || v > 0777)) ? "must be between 0 and 0777" : nullptr;
+        }},
+    Field<Environment>{
+        .name = "additional_env",
+        .member = &ProgramSpec::environment},
+    Field<std::vector<string> >{
+        .name = "depends_on",
+        .member = &ProgramSpec::dependsOn,
+        // a single name or a list
+        .decode = [](const YAML::Node & n, std::vector<string> & out) {
+            out = (n.IsSequence()) ? n.as<std::vector<string> >() : std::vector<string>{n.as<string>()};
+        }},
+    Field<int>{
+        .name = "priority",
+        .member = &ProgramSpec::priority},
+    Field<double>{
+        .name = "start_delay",
+        .member = &ProgramSpec::startDelay,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<std::vector<string> >{
+        .name = "sockets",
+        .member = &ProgramSpec::sockets,
+        .flags = Restart,
+        .check = [](const std::vector<string> & v) -> const char * {
+            struct sockaddr_storage storage;
+            socklen_t size;
+            return std::all_of(v.begin(), v.end(), [&](const string & address) {
+                return ListenSocket::ParseAddress(address, storage, size) == 0;
+            }) ? nullptr : "must be ports, host:port or unix socket paths";
+        },
+        // a single address or a list
+        .decode = [](const YAML::Node & n, std::vector<string> & out) {
+            out = (n.IsSequence()) ? n.as<std::vector<string> >() : std::vector<string>{n.as<string>()};
+        }},
+    Field<bool>{
+        .name = "lazy_start",
+        .member = &ProgramSpec::lazyStart},
+    Field<double>{
+        .name = "idle_timeout",
+        .member = &ProgramSpec::idleTimeout,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<string>{
+        .name = "autoscale_metric",
+        .member = &ProgramSpec::autoscaleMetric,
+        .check = [](const string & v) -> const char * {
+            return (v.empty() || v == "cpu" || v == "command" || v == "push") ?
+                nullptr : "must be cpu, command or push";
+        }},
+    Field<string>{
+        .name = "autoscale_command",
+        .member = &ProgramSpec::autoscaleCommand},
+    Field<int>{
+        .name = "autoscale_min",
+        .member = &ProgramSpec::autoscaleMin,
+        .check = [](const int & v) -> const char * { return (v < 1) ? "must be at least 1" : nullptr; }},
+    Field<int>{
+        .name = "autoscale_max",
+        .member = &ProgramSpec::autoscaleMax,
+        .check = [](const int & v) -> const char * { return (v < 1) ? "must be at least 1" : nullptr; }},
+    Field<double>{
+        .name = "autoscale_target",
+        .member = &ProgramSpec::autoscaleTarget,
+        .check = [](const double & v) -> const char * { return (v <= 0.0) ? "must be more than 0" : nullptr; }},
+    Field<double>{
+        .name = "autoscale_interval",
+        .member = &ProgramSpec::autoscaleInterval,
+        .check = [](const double & v) -> const char * { return (v <= 0.0) ? "must be more than 0" : nullptr; }},
+    Field<double>{
+        .name = "autoscale_cooldown",
+        .member = &ProgramSpec::autoscaleCooldown,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<int>{
+        .name = "autoscale_step",
+        .member = &ProgramSpec::autoscaleStep,
+        .check = [](const int & v) -> const char * { return (v < 1) ? "must be at least 1" : nullptr; }},
+    Field<string>{
+        .name = "schedule",
+        .member = &ProgramSpec::schedule,
+        .check = [](const string & v) -> const char * {
+            Schedule schedule;
+            string error;
+            return (v.empty() || Schedule::Parse(v, schedule, error) == 0) ?
+                nullptr : "must be a cron expression (minute hour day month weekday), @daily... or @every <n>s|m|h";
+        }},
+    Field<double>{
+        .name = "schedule_jitter",
+        .member = &ProgramSpec::scheduleJitter,
+        .check = [](const double & v) -> const char * { return (v < 0.0) ? "must be positive" : nullptr; }},
+    Field<string>{
+        .name = "schedule_overlap",
+        .member = &ProgramSpec::scheduleOverlap,
+        .check = [](const string & v) -> const char * {
+            return (v == "skip" || v == "queue" || v == "kill-previous") ?
+                nullptr : "must be skip, queue or kill-previous";
+        }},
+    Field<bool>{
+        .name = "schedule_catch_up",
+        .member = &ProgramSpec::scheduleCatchUp},
+    Field<int>{
+        .name = "job_pool_size",
+        .member = &ProgramSpec::jobPoolSize,
+        .check = [](const int & v) -> const char * { return (v < 0) ? "must be positive" : nullptr; }},
+    Field<int>{
+        .name = "job_queue_size",
+        .member = &ProgramSpec::jobQueueSize,
+        .check = [](const int & v) -> const char * { return (v < 1) ? "must be at least 1" : nullptr; }}
+);
+
+constexpr size_t NumberOfFields = std::tuple_size_v<decltype(Fields)>;
+
+/*
+** (name, position in Fields) sorted by name, to find a key's field by binary search
+*/
+constexpr auto FieldIndex = [] {
+    std::array<std::pair<std::string_view, size_t>, NumberOfFields> index{};
+    size_t i = 0;
+    std::apply([&](const auto &... fields) { ((index[i] = {fields.name, i}, ++i), ...); }, Fields);
+    std::sort(index.begin(), index.end());
+    return index;
+}();
+
+static_assert(std::adjacent_find(FieldIndex.begin(), FieldIndex.end(),
+    [](const auto & a, const auto & b) { return a.first == b.first; }) == FieldIndex.end(),
+    "duplicate key in the program field table");
+
+template <typename F>
+auto ForEachField(F && f) -> void
+{
+    std::apply([&](const auto &... fields) { (f(fields), ...); }, Fields);
+}
+
+template <typename F>
+auto VisitField(size_t index, F && f) -> void
+{
+    size_t i = 0;
+    std::apply([&](const auto &... fields) { ((i++ == index ? f(fields) : void()), ...); }, Fields);
+}
+
+static auto FindField(std::string_view key) -> size_t
+{
+    auto it = std::lower_bound(FieldIndex.begin(), FieldIndex.end(), key,
+        [](const auto & entry, std::string_view k) { return entry.first < k; });
+    return (it != FieldIndex.end() && it->first == key) ? it->second : NumberOfFields;
+}
+
+/*
+** decoding: YAML::Node::as<T>() unless the type needs a special case
+*/
+template <typename T>
+auto Decode(const YAML::Node & node, T & out) -> void
+{
+    out = node.as<T>();
+}
+
+// a single value or a list
+auto Decode(const YAML::Node & node, std::vector<int> & out) -> void
+{
+    out.clear();
+    if (node.IsSequence())
+    {
+        for (auto item : node)
+        {
+            out.push_back(item.as<int>());
+        }
+        return ;
+    }
+    out.push_back(node.as<int>());
+}
+
+auto Decode(const YAML::Node & node, ShouldRestart & out) -> void
+{
+    out = (ShouldRestart)node.as<int>();
+}
+
+// a list of KEY: value maps, applied over the supervisor's environment
+auto Decode(const YAML::Node & node, Environment & out) -> void
+{
+    for (auto i : node)
+    {
+        if (i.Type() != YAML::NodeType::Map)
+            break;
+        for (auto & v : i.as<std::map<string, string> >())
+        {
+            out.set(v.first, v.second);
+        }
+    }
+}
+
+/*
+** hashing
+*/
+static auto HashCombine(size_t seed, size_t h) -> size_t
+{
+    return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+template <typename T>
+auto HashValue(const T & v) -> size_t
+{
+    return std::hash<T>{}(v);
+}
+
+template <typename T>
+auto HashValue(const std::vector<T> & v) -> size_t
+{
+    size_t h = v.size();
+    for (auto & item : v)
+    {
+        h = HashCombine(h, HashValue(item));
+    }
+    return h;
+}
+
+auto HashValue(const Environment & v) -> size_t
+{
+    return HashCombine(HashValue(v.getBase().get()), HashValue(v.getOverrides()));
+}
+
+/*
+** printing
+*/
+template <typename T>
+auto PrintValue(std::ostream & out, const T & v) -> void
+{
+    out << v;
+}
+
+auto PrintValue(std::ostream & out, const string & v) -> void
+{
+    out << "\"" << v << "\"";
+}
+
+auto PrintValue(std::ostream & out, const bool & v) -> void
+{
+    out << (v ? "true" : "false");
+}
+
+auto PrintValue(std::ostream & out, const ShouldRestart & v) -> void
+{
+    out << (int)v;
+}
+
+template <typename T>
+auto PrintValue(std::ostream & out, const std::vector<T> & v) -> void
+{
+    out << "[";
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        out << ((i == 0) ? "" : ", ");
+        PrintValue(out, v[i]);
+    }
+    out << "]";
+}
+
+// only the overrides, the base is the supervisor's own environment
+auto PrintValue(std::ostream & out, const Environment & v) -> void
+{
+    PrintValue(out, v.getOverrides());
+}
+};
+
+namespace ProgramSchema {
+
+bool Bind(
+    const YAML::Node & node,
+    ProgramSpec & spec,
+    std::vector<ValidationIssue> & issues)
+{
+    std::bitset<NumberOfFields> seen;
+    size_t first_issue = issues.size();
+    bool is_valid = true;
+
+    for (auto it = node.begin(); it != node.end(); ++it)
+    {
+        const string & key = it->first.Scalar();
+        size_t index = FindField(key);
+        if (index == NumberOfFields)
+        {
+            issues.push_back({"", key, "unknown key, ignored"});
+            continue;
+        }
+        seen.set(index);
+        VisitField(index, [&](const auto & field) {
+            try {
+                if (field.decode)
+                {field.decode(it->second, spec.*field.member);}
+                else
+                {Decode(it->second, spec.*field.member);}
+            } catch (const YAML::Exception & e) {
+                issues.push_back({"", string(field.name), "invalid value (line " + std::to_string(e.mark.line + 1) + ")"});
+                is_valid = false;
+            }
+        });
+    }
+
+    size_t index = 0;
+    ForEachField([&](const auto & field) {
+        if ((field.flags & Required) && !seen.test(index))
+        {
+            issues.push_back({"", string(field.name), "does not exist or is invalid"});
+            is_valid = false;
+        }
+        ++index;
+    });
+
+    size_t n_issues = issues.size();
+    Validate(spec, issues);
+    is_valid = is_valid && n_issues == issues.size();
+    for (size_t i = first_issue; i < issues.size(); ++i)
+    {
+        issues[i].program = spec.name;
+    }
+    return is_valid;
+}
+
+void Validate(const ProgramSpec & spec, std::vector<ValidationIssue> & issues)
+{
+    ForEachField([&](const auto & field) {
+        if (!field.check)
+        {
+            return ;
+        }
+        const char * error = field.check(spec.*field.member);
+        if (error)
+        {
+            issues.push_back({spec.name, string(field.name), error});
+        }
+    });
+}
+
+size_t Hash(const ProgramSpec & spec)
+{
+    size_t h = 0;
+
+    ForEachField([&](const auto & field) {
+        h = HashCombine(h, HashValue(spec.*field.member));
+    });
+    return h;
+}
+
+std::vector<std::string_view> Diff(const ProgramSpec & a, const ProgramSpec & b)
+{
+    std::vector<std::string_view> out;
+
+    ForEachField([&](const auto & field) {
+        if (!(a.*field.member == b.*field.member))
+        {
+            out.push_back(field.name);
+        }
+    });
+    return out;
+}
+
+bool NeedsRestart(const ProgramSpec & a, const ProgramSpec & b)
+{
+    bool restart = false;
+
+    ForEachField([&](const auto & field) {
+        restart = restart || ((field.flags & Restart) && !(a.*field.member == b.*field.member));
+    });
+    return restart;
+}
+
+void Print(std::ostream & out, const ProgramSpec & spec)
+{
+    ForEachField([&](const auto & field) {
+        out << "\n\t" << field.name << ": ";
+        PrintValue(out, spec.*field.member);
+    });
+}
+};
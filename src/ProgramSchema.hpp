@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ProgramSpec.hpp"
+#include "Validator.hpp"
+
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using std::string;
+
+/*
+** every config key of a program is described once, in the field table of
+** ProgramSchema.cpp. the functions below are all generated from that table.
+*/
+namespace ProgramSchema {
+
+    /*
+    ** fill spec from a `supervisor-processes` entry in a single pass over its keys.
+    ** spec is expected to hold the defaults (and the base environment).
+    ** returns false if the program can not be loaded, with the reasons in issues.
+    */
+    bool Bind(
+        const YAML::Node & node,
+        ProgramSpec & spec,
+        std::vector<ValidationIssue> & issues);
+
+    /*
+    ** value checks declared in the table (ranges, signals, ...)
+    */
+    void Validate(const ProgramSpec & spec, std::vector<ValidationIssue> & issues);
+
+    size_t Hash(const ProgramSpec & spec);
+
+    /*
+    ** names of the keys whose value differs between a and b
+    */
+    std::vector<std::string_view> Diff(const ProgramSpec & a, const ProgramSpec & b);
+
+    /*
+    ** true if a key marked as requiring a restart differs between a and b
+    */
+    bool NeedsRestart(const ProgramSpec & a, const ProgramSpec & b);
+
+    /*
+    ** one `key: value` line per field
+    */
+    void Print(std::ostream & out, const ProgramSpec & spec);
+};
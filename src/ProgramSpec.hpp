@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Environment.hpp"
+#include "ListenSocket.hpp"
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using std::string;
+
+typedef enum ShouldRestart {
+    Never,
+    UnexpectedExit,
+    Always
+} ShouldRestart;
+
+/*
+** everything the config says about a program. built once per config entry
+** and shared (read-only) by every replica started from it: a reload that
+** changes a program builds a new spec instead of modifying this one.
+** the values below are the defaults of missing keys, see ProgramSchema.cpp
+** for the key each member is read from.
+*/
+typedef struct ProgramSpec {
+    bool execOnStartup = false;
+    bool redirectStreams = false;
+    std::vector<int> expectedReturnValues;
+    int numberOfRestarts = 1;
+    int numberOfProcesses = 1;
+    // extra processes started along the replicas and held once READY, one of
+    // them takes the place of a replica which dies
+    int warmSpares = 0;
+    int killSignal = SIGTERM;
+    // seconds between kill_signal and SIGKILL
+    double forceQuitWaitTime = 10.0;
+    int umask = -1;
+    ShouldRestart shouldRestart = ShouldRestart::Never;
+    long double startTime = 0.0;
+    // fd on which the program writes a newline once it is ready, -1 to
+    // consider it ready after start_time instead
+    int readyFd = -1;
+    // seconds to wait for that newline, 0 for no limit
+    double readyTimeout = 0.0;
+    string fullPath;
+    string name;
+    string workingDir;
+    string outputRedirectPath;
+    std::vector<string> commandArguments;
+    Environment environment;
+    // names of the programs to start before this one, see DependencyGraph
+    std::vector<string> dependsOn;
+    // boot class, lower ones start first: the next class starts once every
+    // program of this one is ready, see Supervisor::startInOrder
+    int priority = 0;
+    // seconds over which the launches of the program's class are spread
+    // (the largest start_delay of the class). once it expired, the next
+    // class starts without waiting for this one to be ready
+    double startDelay = 0.0;
+    // addresses listened on by the supervisor, passed to the processes as
+    // fds 3, 4... with LISTEN_FDS and LISTEN_PID
+    std::vector<string> sockets;
+    // start on the first connection to one of the sockets instead
+    bool lazyStart = false;
+    // seconds without a new connection to the sockets after which the
+    // program is stopped, until the next one. 0 to keep it running
+    double idleTimeout = 0.0;
+    // "cpu", "command" or "push" to resize the group between autoscale_min
+    // and autoscale_max, empty for number_of_processes. see Autoscaler
+    string autoscaleMetric;
+    // run by /bin/sh with the "command" metric
+    string autoscaleCommand;
+    int autoscaleMin = 1;
+    int autoscaleMax = 1;
+    // the share of the metric each replica should take
+    double autoscaleTarget = 1.0;
+    // seconds between two samples
+    double autoscaleInterval = 5.0;
+    // seconds after a change before the next one
+    double autoscaleCooldown = 30.0;
+    // replicas added or removed at once, at most
+    int autoscaleStep = 1;
+    // when the program is started, see Schedule. empty if it is not scheduled
+    string schedule;
+    // seconds, a random delay up to this is added to each run
+    double scheduleJitter = 0.0;
+    // when the previous run still runs: "skip", "queue" (run once it exited)
+    // or "kill-previous"
+    string scheduleOverlap = "skip";
+    // a run missed (the supervisor was stopped, the machine suspended) is
+    // made up once, instead of waiting for the next one
+    bool scheduleCatchUp = false;
+    // jobs run at once, 0 if the program is not a job pool. a pool starts
+    // no process of its own: each submitted job runs start_command with
+    // its arguments appended, see Supervisor::submit
+    int jobPoolSize = 0;
+    // jobs waiting for a free slot, past which a submission is rejected
+    int jobQueueSize = 100;
+
+    // bound from `sockets` by the supervisor, not a config key
+    std::vector<std::shared_ptr<ListenSocket> > listenSockets;
+
+    // ProgramSchema::Hash() of the above, set once the spec is built
+    size_t hash = 0;
+} ProgramSpec;
@@ -0,0 +1,221 @@
+#include "Schedule.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <ctime>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+static auto ParseNumber(std::string_view text, int & value) -> bool
+{
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == std::errc() && end == text.data() + text.size();
+}
+
+/*
+** one cron field: comma separated items, each one *, n or a-b, with an
+** optional /step. sets the bits of the matching values in bits
+*/
+static auto ParseField(std::string_view field, int min, int max, uint64_t & bits) -> bool
+{
+    bits = 0;
+    while (!field.empty())
+    {
+        size_t comma = field.find(',');
+        std::string_view item = field.substr(0, comma);
+        field = (comma == std::string_view::npos) ? std::string_view() : field.substr(comma + 1);
+
+        size_t slash = item.find('/');
+        std::string_view range = item.substr(0, slash);
+        int step = 1, low = min, high = max;
+        if (slash != std::string_view::npos && (!ParseNumber(item.substr(slash + 1), step) || step < 1))
+        {
+            return false;
+        }
+        if (range != "*")
+        {
+            size_t dash = range.find('-');
+            if (!ParseNumber(range.substr(0, dash), low))
+            {
+                return false;
+            }
+            // n/step goes from n to the end
+            high = (dash != std::string_view::npos) ? -1 : (slash != std::string_view::npos) ? max : low;
+            if (dash != std::string_view::npos && !ParseNumber(range.substr(dash + 1), high))
+            {
+                return false;
+            }
+        }
+        if (low < min || high > max || low > high)
+        {
+            return false;
+        }
+        for (int value = low; value <= high; value += step)
+        {
+            bits |= (uint64_t)1 << value;
+        }
+    }
+    return bits != 0;
+}
+
+static auto Unit(char unit) -> double
+{
+    switch (unit)
+    {
+        case 's': return 1.0;
+        case 'm': return 60.0;
+        case 'h': return 3600.0;
+        default: return 0.0;
+    }
+}
+
+};
+
+Schedule::Schedule() :
+    mInterval(0.0),
+    mMinutes(0),
+    mHours(0),
+    mDaysOfMonth(0),
+    mMonths(0),
+    mDaysOfWeek(0),
+    mIsDayOfMonthRestricted(false),
+    mIsDayOfWeekRestricted(false)
+{}
+
+Schedule::~Schedule() {}
+
+int Schedule::Parse(std::string_view expression, Schedule & schedule, string & error)
+{
+    static const std::pair<std::string_view, std::string_view> Aliases[] = {
+        {"@hourly", "0 * * * *"},
+        {"@daily", "0 0 * * *"},
+        {"@weekly", "0 0 * * 0"},
+        {"@monthly", "0 0 1 * *"},
+        {"@yearly", "0 0 1 1 *"},
+    };
+    std::string_view cron = expression;
+
+    schedule = Schedule();
+    schedule.mExpression = string(expression);
+    error = "schedule: " + schedule.mExpression + ": ";
+    if (expression.substr(0, 7) == "@every ")
+    {
+        string interval(expression.substr(7));
+        char *end = nullptr;
+        double value = std::strtod(interval.c_str(), &end);
+        double unit = (*end == '\0') ? 1.0 : (end[1] == '\0') ? Unit(*end) : 0.0;
+        if (end == interval.c_str() || !std::isfinite(value) || value * unit <= 0.0)
+        {
+            error += "@every takes a duration, eg: 30s, 5m, 2h";
+            return 1;
+        }
+        schedule.mInterval = value * unit;
+        return 0;
+    }
+    for (auto & [alias, replacement] : Aliases)
+    {
+        cron = (expression == alias) ? replacement : cron;
+    }
+
+    std::vector<string> fields;
+    std::istringstream words{string(cron)};
+    for (string word; words >> word;)
+    {
+        fields.push_back(word);
+    }
+    uint64_t minutes, hours, days_of_month, months, days_of_week;
+    if (fields.size() != 5)
+    {
+        error += "expected 5 fields (minute hour day-of-month month day-of-week), @hourly... or @every";
+        return 1;
+    }
+    if (!ParseField(fields[0], 0, 59, minutes) || !ParseField(fields[1], 0, 23, hours) ||
+        !ParseField(fields[2], 1, 31, days_of_month) || !ParseField(fields[3], 1, 12, months) ||
+        !ParseField(fields[4], 0, 7, days_of_week))
+    {
+        error += "a field is out of range or malformed";
+        return 1;
+    }
+    schedule.mMinutes = minutes;
+    schedule.mHours = hours;
+    schedule.mDaysOfMonth = days_of_month;
+    schedule.mMonths = months;
+    // 7 is sunday too
+    schedule.mDaysOfWeek = (days_of_week | (days_of_week >> 7)) & 0x7f;
+    schedule.mIsDayOfMonthRestricted = fields[2] != "*";
+    schedule.mIsDayOfWeekRestricted = fields[4] != "*";
+    return 0;
+}
+
+/*
+** goes forward by the largest unit which does not match, at most a few
+** years of them
+*/
+double Schedule::next(double after) const
+{
+    if (mInterval > 0.0)
+    {
+        return after + mInterval;
+    }
+    time_t t = (time_t)std::floor(after / 60.0) * 60 + 60;
+    struct tm tm;
+    ::localtime_r(&t, &tm);
+    tm.tm_sec = 0;
+
+    for (int i = 0; i < 5 * 366 * 24; ++i)
+    {
+        tm.tm_isdst = -1;
+        t = ::mktime(&tm);
+        if (!(mMonths & (1 << (tm.tm_mon + 1))))
+        {
+            tm.tm_mon += 1;
+            tm.tm_mday = 1;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+        }
+        else if (!matchesDay(tm.tm_mday, tm.tm_wday))
+        {
+            tm.tm_mday += 1;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+        }
+        else if (!(mHours & (1u << tm.tm_hour)))
+        {
+            tm.tm_hour += 1;
+            tm.tm_min = 0;
+        }
+        else if (!(mMinutes & ((uint64_t)1 << tm.tm_min)))
+        {
+            tm.tm_min += 1;
+        }
+        else
+        {
+            return (double)t;
+        }
+    }
+    return -1.0;
+}
+
+double Schedule::getInterval() const
+{
+    return mInterval;
+}
+
+const string & Schedule::getExpression() const
+{
+    return mExpression;
+}
+
+bool Schedule::matchesDay(int day_of_month, int day_of_week) const
+{
+    bool is_day_of_month = mDaysOfMonth & (1u << day_of_month);
+    bool is_day_of_week = mDaysOfWeek & (1u << day_of_week);
+
+    if (mIsDayOfMonthRestricted && mIsDayOfWeekRestricted)
+    {
+        return is_day_of_month || is_day_of_week;
+    }
+    return is_day_of_month && is_day_of_week;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using std::string;
+
+/*
+** when a program runs, from its `schedule` key:
+**   "m h dom mon dow"  a cron expression, in local time. each field is *,
+**                      a number, a range a-b, a list a,b,c, each of them
+**                      with an optional /step. dow is 0-7, 0 and 7 are sunday.
+**                      when both dom and dow are restricted, either matches.
+**   "@hourly", "@daily", "@weekly", "@monthly", "@yearly"
+**   "@every 30s"       a fixed interval, in s, m or h (s without a unit)
+** times are seconds since the epoch, as doubles.
+*/
+class Schedule {
+public:
+        /*
+        ** xtors
+        */
+        Schedule();
+        ~Schedule();
+
+        /*
+        ** business logic
+        */
+        // returns 1 and fills error if expression is not a schedule
+        static int Parse(std::string_view expression, Schedule & schedule, string & error);
+        // the first time strictly after `after`, -1 if there is none (eg: 30 2 31 2 *).
+        // an interval counts from `after`
+        double next(double after) const;
+
+        /*
+        ** get/setters
+        */
+        // 0 for a cron expression
+        double getInterval() const;
+        const string & getExpression() const;
+private:
+        /*
+        ** private functions
+        */
+        bool matchesDay(int day_of_month, int day_of_week) const;
+
+        /*
+        ** class members
+        */
+        string mExpression;
+        double mInterval;
+        // bit n set when value n matches
+        uint64_t mMinutes;
+        uint32_t mHours;
+        uint32_t mDaysOfMonth;
+        uint16_t mMonths;
+        uint8_t mDaysOfWeek;
+        bool mIsDayOfMonthRestricted;
+        bool mIsDayOfWeekRestricted;
+};
@@ -0,0 +1,288 @@
+#include "StatusQuery.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <fnmatch.h>
+
+namespace {
+
+static const char * FieldNames[] = {
+    "name", "group", "state", "pid", "uptime", "restarts", "exit_code", "signal",
+    "start_time", "exit_time", "user_time", "system_time", "max_rss", "ready_latency"
+};
+
+/*
+** calls f on each non-empty item of a comma separated list
+*/
+template <typename F>
+static auto ForEachItem(std::string_view list, F f) -> int
+{
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = (comma == std::string_view::npos) ? std::string_view() : list.substr(comma + 1);
+        if (!item.empty() && f(item) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static auto Seconds(const struct timeval & time) -> double
+{
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+};
+
+StatusQuery::StatusQuery() :
+    mFormat(Text)
+{}
+
+StatusQuery::~StatusQuery() {}
+
+const char * StatusQuery::FieldName(Field field)
+{
+    return (field >= 0 && field < NumberOfFields) ? FieldNames[field] : "unknown";
+}
+
+int StatusQuery::FindField(std::string_view name, Field & field)
+{
+    for (int i = 0; i < NumberOfFields; ++i)
+    {
+        if (name == FieldNames[i])
+        {
+            field = (Field)i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int StatusQuery::parse(Format format, std::string_view fields, std::string_view where, string & error)
+{
+    mFormat = format;
+    mFields.clear();
+    mConditions.clear();
+
+    if (ForEachItem(fields, [&] (std::string_view name) {
+            Field field;
+            if (FindField(name, field) != 0)
+            {
+                error = "status: unknown field " + string(name);
+                return 1;
+            }
+            mFields.push_back(field);
+            return 0;
+        }) != 0)
+    {
+        return 1;
+    }
+    if (mFields.empty())
+    {
+        mFields = {Name, State, Pid, Uptime, Restarts, ExitCode};
+    }
+
+    return ForEachItem(where, [&] (std::string_view condition) {
+        size_t op_pos = condition.find_first_of("=!<>");
+        if (op_pos == std::string_view::npos || op_pos == 0)
+        {
+            error = "status: malformed condition " + string(condition) + " (eg: state=FATAL)";
+            return 1;
+        }
+        Condition c;
+        if (FindField(condition.substr(0, op_pos), c.field) != 0)
+        {
+            error = "status: unknown field " + string(condition.substr(0, op_pos));
+            return 1;
+        }
+        size_t value_pos = op_pos + 1;
+        switch (condition[op_pos])
+        {
+            case '=': c.op = Equal; break;
+            case '<': c.op = Less; break;
+            case '>': c.op = Greater; break;
+            default:
+                if (condition.substr(op_pos, 2) != "!=")
+                {
+                    error = "status: malformed condition " + string(condition);
+                    return 1;
+                }
+                c.op = NotEqual;
+                value_pos = op_pos + 2;
+        }
+        c.value = condition.substr(value_pos);
+        c.number = 0;
+        auto [end, ec] = std::from_chars(c.value.data(), c.value.data() + c.value.size(), c.number);
+        bool is_number = ec == std::errc() && end == c.value.data() + c.value.size();
+        if ((c.op == Less || c.op == Greater) && !is_number)
+        {
+            error = "status: " + string(condition) + ": < and > compare numbers";
+            return 1;
+        }
+        mConditions.push_back(c);
+        return 0;
+    });
+}
+
+bool StatusQuery::matches(const Process & process, time_t now) const
+{
+    for (auto & condition : mConditions)
+    {
+        Value value = GetValue(process, condition.field, now);
+        bool is_equal;
+        if (value.isText)
+        {
+            // fnmatch needs a terminated string: text values all are
+            is_equal = ::fnmatch(condition.value.c_str(), value.text.data(), 0) == 0;
+        }
+        else
+        {
+            is_equal = value.number == condition.number;
+        }
+        if ((condition.op == Equal && !is_equal) ||
+            (condition.op == NotEqual && is_equal) ||
+            (condition.op == Less && !(value.number < condition.number)) ||
+            (condition.op == Greater && !(value.number > condition.number)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StatusQuery::writeHeader(string & buffer) const
+{
+    if (mFormat != Tsv)
+    {
+        return ;
+    }
+    for (size_t i = 0; i < mFields.size(); ++i)
+    {
+        buffer += (i == 0) ? "" : "\t";
+        buffer += FieldNames[mFields[i]];
+    }
+    buffer += '\n';
+}
+
+void StatusQuery::writeRow(const Process & process, time_t now, string & buffer) const
+{
+    buffer += (mFormat == Json) ? "{" : "";
+    for (size_t i = 0; i < mFields.size(); ++i)
+    {
+        Value value = GetValue(process, mFields[i], now);
+        switch (mFormat)
+        {
+            case Json:
+                buffer += (i == 0) ? "\"" : ",\"";
+                buffer += FieldNames[mFields[i]];
+                buffer += "\":";
+                AppendValue(buffer, value, true);
+                break;
+            case Tsv:
+                buffer += (i == 0) ? "" : "\t";
+                AppendValue(buffer, value, false);
+                break;
+            case Text:
+                buffer += (i == 0) ? "" : " ";
+                buffer += FieldNames[mFields[i]];
+                buffer += '=';
+                AppendValue(buffer, value, false);
+                break;
+        }
+    }
+    buffer += (mFormat == Json) ? "}\n" : "\n";
+}
+
+StatusQuery::Format StatusQuery::getFormat() const
+{
+    return mFormat;
+}
+
+StatusQuery::Value StatusQuery::GetValue(const Process & process, Field field, time_t now)
+{
+    const struct rusage & usage = process.getUsage();
+
+    switch (field)
+    {
+        case Name:
+        {
+            auto name = process.shareProcessName();
+            return {*name, 0, true, name};
+        }
+        case Group:
+        {
+            auto spec = process.getSpec();
+            return {spec->name, 0, true, spec};
+        }
+        case State:
+            return {ProcessStateName(process.getState()), 0, true};
+        case Pid:
+            return {{}, (double)((process.isAlive()) ? process.getPid() : 0), false};
+        case Uptime:
+            return {{}, (process.isAlive()) ? (double)(now - (time_t)process.getExecTime()) : 0.0, false};
+        case Restarts:
+            return {{}, (double)process.getRestarts(), false};
+        case ExitCode:
+            return {{}, (double)process.getReturnValue(), false};
+        case Signal:
+            return {{}, (double)process.getLastSignal(), false};
+        case StartTime:
+            return {{}, (double)process.getExecTime(), false};
+        case ExitTime:
+            return {{}, (double)process.getExitWallTime(), false};
+        case UserTime:
+            return {{}, Seconds(usage.ru_utime), false};
+        case SystemTime:
+            return {{}, Seconds(usage.ru_stime), false};
+        case MaxRss:
+            return {{}, (double)usage.ru_maxrss, false};
+        case ReadyLatency:
+            return {{}, process.getReadyLatency(), false};
+        default:
+            return {{}, 0, false};
+    }
+}
+
+void StatusQuery::AppendValue(string & buffer, const Value & value, bool quote)
+{
+    char number[32];
+
+    if (!value.isText)
+    {
+        auto result = (value.number == std::floor(value.number) && std::fabs(value.number) < 1e15) ?
+            std::to_chars(number, number + sizeof(number), (long long)value.number) :
+            std::to_chars(number, number + sizeof(number), value.number);
+        buffer.append(number, result.ptr - number);
+        return ;
+    }
+    if (!quote)
+    {
+        // names and states have no tabs nor newlines
+        buffer += value.text;
+        return ;
+    }
+    buffer += '"';
+    for (char c : value.text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            buffer += '\\';
+            buffer += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            auto result = std::to_chars(number, number + sizeof(number), (int)c, 16);
+            buffer += "\\u00";
+            buffer += (result.ptr - number == 1) ? "0" : "";
+            buffer.append(number, result.ptr - number);
+        }
+        else
+        {
+            buffer += c;
+        }
+    }
+    buffer += '"';
+}
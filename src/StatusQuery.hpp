@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Process.hpp"
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+
+/*
+** status --json|--tsv [--fields f,f...] [--where cond,cond...] [targets]
+**
+** fields: name group state pid uptime restarts exit_code signal start_time
+** exit_time user_time system_time max_rss ready_latency (times in seconds,
+** max_rss in kB, ready_latency is -1 until the process is READY).
+** conditions are ANDed, each one is field=value, field!=value (values may be
+** globs, eg: name=web_*), or field<n, field>n for numeric fields.
+**
+** rows are serialized into a caller-owned buffer, which is reused from one
+** query to the next: the caller writes it out and clears it whenever it gets
+** big, so a query over many processes never holds the whole output.
+** --json writes one object per line.
+*/
+class StatusQuery {
+public:
+        typedef enum Format {
+            Text,
+            Json,
+            Tsv
+        } Format;
+
+        typedef enum Field {
+            Name,
+            Group,
+            State,
+            Pid,
+            Uptime,
+            Restarts,
+            ExitCode,
+            Signal,
+            StartTime,
+            ExitTime,
+            UserTime,
+            SystemTime,
+            MaxRss,
+            ReadyLatency,
+            NumberOfFields
+        } Field;
+
+        /*
+        ** xtors
+        */
+        StatusQuery();
+        ~StatusQuery();
+
+        /*
+        ** business logic
+        */
+        // returns 1 and fills error on an unknown field or a malformed condition
+        int parse(Format format, std::string_view fields, std::string_view where, string & error);
+        bool matches(const Process & process, time_t now) const;
+        void writeHeader(string & buffer) const;
+        void writeRow(const Process & process, time_t now, string & buffer) const;
+
+        static const char * FieldName(Field field);
+
+        /*
+        ** get/setters
+        */
+        Format getFormat() const;
+private:
+        typedef enum Operator {
+            Equal,
+            NotEqual,
+            Less,
+            Greater
+        } Operator;
+
+        typedef struct Condition {
+            Field field;
+            Operator op;
+            string value;
+            double number;
+        } Condition;
+
+        // a field of a process, as text or as a number
+        typedef struct Value {
+            std::string_view text;
+            double number;
+            bool isText;
+            // what text points into: a promotion renames the process and a
+            //  reload swaps its spec meanwhile
+            std::shared_ptr<const void> owner = nullptr;
+        } Value;
+
+        /*
+        ** private functions
+        */
+        static int FindField(std::string_view name, Field & field);
+        static Value GetValue(const Process & process, Field field, time_t now);
+        static void AppendValue(string & buffer, const Value & value, bool quote);
+
+        /*
+        ** class members
+        */
+        Format mFormat;
+        std::vector<Field> mFields;
+        std::vector<Condition> mConditions;
+};
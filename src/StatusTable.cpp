@@ -0,0 +1,217 @@
+#include "StatusTable.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+StatusTable::StatusTable() :
+    mIsOwner(false),
+    mMap(nullptr),
+    mSize(0),
+    mHeader(nullptr),
+    mEntries(nullptr)
+{}
+
+StatusTable::~StatusTable()
+{
+    close();
+}
+
+/*
+** create (or replace) the segment. returns -1 and sets errno on failure
+*/
+int StatusTable::create(const string & name, uint32_t capacity)
+{
+    int fd;
+
+    mSize = sizeof(Header) + capacity * sizeof(Entry);
+    if ((fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)) == -1)
+    {
+        return -1;
+    }
+    if (::ftruncate(fd, mSize) == -1 ||
+        (mMap = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    {
+        int err = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        mMap = nullptr;
+        errno = err;
+        return -1;
+    }
+    ::close(fd);
+    mName = name;
+    mIsOwner = true;
+    // ftruncate zeroed the segment: every entry is free with an even sequence
+    mHeader = new (mMap) Header;
+    mEntries = (Entry *)((char *)mMap + sizeof(Header));
+    mHeader->capacity = capacity;
+    mHeader->entrySize = sizeof(Entry);
+    mHeader->supervisorPid = ::getpid();
+    mHeader->version = Version;
+    mHeader->highWater.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    // readers check the magic last
+    mHeader->magic = Magic;
+
+    mFreeSlots.clear();
+    for (uint32_t i = capacity; i > 0; --i)
+    {
+        mFreeSlots.push_back(i - 1);
+    }
+    return 0;
+}
+
+/*
+** reserve an entry, lowest free slot first. returns -1 if the table is full
+*/
+int StatusTable::acquire()
+{
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+
+    if (!mHeader || mFreeSlots.empty())
+    {
+        return -1;
+    }
+    int slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    if ((uint32_t)slot + 1 > mHeader->highWater.load(std::memory_order_relaxed))
+    {
+        mHeader->highWater.store(slot + 1, std::memory_order_release);
+    }
+    return slot;
+}
+
+void StatusTable::release(int slot)
+{
+    EntryData empty = {};
+
+    if (slot < 0 || !mHeader)
+    {
+        return ;
+    }
+    write(slot, empty);
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    mFreeSlots.push_back(slot);
+}
+
+void StatusTable::write(int slot, const EntryData & data)
+{
+    if (slot < 0 || !mHeader || (uint32_t)slot >= mHeader->capacity)
+    {
+        return ;
+    }
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    Entry & entry = mEntries[slot];
+    uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy((void *)&entry.data, &data, sizeof(data));
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/*
+** map an existing segment read-only. returns -1 and sets errno on failure
+*/
+int StatusTable::open(const string & name)
+{
+    struct stat st;
+    int fd;
+
+    if ((fd = ::shm_open(name.c_str(), O_RDONLY, 0)) == -1)
+    {
+        return -1;
+    }
+    if (::fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(Header) ||
+        (mMap = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    {
+        int err = (errno) ? errno : EINVAL;
+        ::close(fd);
+        mMap = nullptr;
+        errno = err;
+        return -1;
+    }
+    ::close(fd);
+    mName = name;
+    mSize = st.st_size;
+    mHeader = (Header *)mMap;
+    mEntries = (Entry *)((char *)mMap + sizeof(Header));
+    if (mHeader->magic != Magic || mHeader->version != Version ||
+        mHeader->entrySize != sizeof(Entry) ||
+        sizeof(Header) + (size_t)mHeader->capacity * sizeof(Entry) > mSize)
+    {
+        close();
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+** copy an entry out. false if the slot is free or kept changing
+*/
+bool StatusTable::read(uint32_t slot, EntryData & data) const
+{
+    if (!mHeader || slot >= mHeader->capacity)
+    {
+        return false;
+    }
+    const Entry & entry = mEntries[slot];
+    for (int attempt = 0; attempt < 1000; ++attempt)
+    {
+        uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+        std::memcpy(&data, (const void *)&entry.data, sizeof(data));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) == before)
+        {
+            data.name[NameSize - 1] = '\0';
+            return data.inUse != 0;
+        }
+    }
+    return false;
+}
+
+bool StatusTable::isOpen() const
+{
+    return mHeader != nullptr;
+}
+
+uint32_t StatusTable::getCapacity() const
+{
+    return (mHeader) ? mHeader->capacity : 0;
+}
+
+uint32_t StatusTable::getHighWater() const
+{
+    return (mHeader) ? mHeader->highWater.load(std::memory_order_acquire) : 0;
+}
+
+int64_t StatusTable::getSupervisorPid() const
+{
+    return (mHeader) ? mHeader->supervisorPid : 0;
+}
+
+void StatusTable::close()
+{
+    if (mMap)
+    {
+        ::munmap(mMap, mSize);
+    }
+    if (mIsOwner)
+    {
+        ::shm_unlink(mName.c_str());
+    }
+    mMap = nullptr;
+    mHeader = nullptr;
+    mEntries = nullptr;
+    mIsOwner = false;
+}
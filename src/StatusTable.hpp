@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+
+/*
+** fixed-layout status of every process, published in a POSIX shared memory
+** segment (shm_open(3)) so that monitoring agents can sample it without
+** talking to the supervisor.
+**
+** the segment is a Header followed by `capacity` Entries. each entry is
+** protected by a seqlock: the supervisor makes `sequence` odd, writes the
+** data, then makes it even again. a reader copies the data between two reads
+** of an even, unchanged sequence, and retries otherwise.
+*/
+class StatusTable {
+public:
+        static const uint32_t Magic = 0x54534d54; // "TMST"
+        static const uint32_t Version = 1;
+        static const uint32_t DefaultCapacity = 4096;
+        static const size_t NameSize = 64;
+
+        typedef struct EntryData {
+            // 0 for a free slot
+            uint32_t inUse;
+            // see ProcessState.hpp
+            uint32_t state;
+            int32_t pid;
+            // exit status of the last run, -1 if killed by a signal
+            int32_t lastExitCode;
+            uint32_t restarts;
+            uint32_t lastSignal;
+            // unix time of the last start and exit
+            int64_t startTime;
+            int64_t exitTime;
+            // resources used by the last run which exited (see wait4(2))
+            uint64_t userTimeUs;
+            uint64_t systemTimeUs;
+            uint64_t maxRssKb;
+            char name[NameSize];
+        } EntryData;
+
+        typedef struct alignas(64) Entry {
+            std::atomic<uint32_t> sequence;
+            EntryData data;
+        } Entry;
+
+        typedef struct alignas(64) Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t capacity;
+            uint32_t entrySize;
+            int64_t supervisorPid;
+            // slots past this one were never used
+            std::atomic<uint32_t> highWater;
+        } Header;
+
+        /*
+        ** xtors
+        */
+        StatusTable();
+        ~StatusTable();
+
+        /*
+        ** business logic
+        */
+        // supervisor side
+        int create(const string & name, uint32_t capacity = DefaultCapacity);
+        int acquire();
+        void release(int slot);
+        void write(int slot, const EntryData & data);
+
+        // reader side
+        int open(const string & name);
+        bool read(uint32_t slot, EntryData & data) const;
+
+        /*
+        ** get/setters
+        */
+        bool isOpen() const;
+        uint32_t getCapacity() const;
+        uint32_t getHighWater() const;
+        int64_t getSupervisorPid() const;
+private:
+        /*
+        ** private functions
+        */
+        void close();
+
+        /*
+        ** class members
+        */
+        string mName;
+        bool mIsOwner;
+        void *mMap;
+        size_t mSize;
+        Header *mHeader;
+        Entry *mEntries;
+
+        // writers only: slots are written by several monitor threads
+        std::mutex mWriteMutex;
+        std::vector<int> mFreeSlots;
+};
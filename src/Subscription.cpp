@@ -0,0 +1,71 @@
+#include "CommandParser.hpp"
+#include "Subscription.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <fnmatch.h>
+
+Subscription::Subscription() {}
+
+Subscription::~Subscription() {}
+
+bool Subscription::IsSubscribeRequest(const string & request)
+{
+    std::vector<std::string_view> words;
+    string storage, error;
+
+    return CommandParser::Tokenize(request, words, storage, error) == 0 &&
+        !words.empty() && words.front() == "subscribe";
+}
+
+/*
+** returns 1 and fills error if the request is malformed
+*/
+int Subscription::parse(const string & request, string & error)
+{
+    std::vector<std::string_view> words;
+    string storage;
+
+    mTargets.clear();
+    mKinds.clear();
+    if (CommandParser::Tokenize(request, words, storage, error) != 0)
+    {
+        error = "subscribe: " + error;
+        return 1;
+    }
+    for (size_t i = 1; i < words.size(); ++i)
+    {
+        if (words[i] != "--events")
+        {
+            mTargets.emplace_back(words[i]);
+            continue;
+        }
+        if (i + 1 >= words.size())
+        {
+            error = "subscribe: --events needs a list of kinds (eg: EXITED,FATAL,exit,reload)";
+            return 1;
+        }
+        for (auto & kind : Utils::SplitString(string(words[++i]), ","))
+        {
+            mKinds.push_back(kind);
+        }
+    }
+    return 0;
+}
+
+bool Subscription::matches(const Event & event) const
+{
+    if (!mKinds.empty() &&
+        std::find(mKinds.begin(), mKinds.end(), event.kind) == mKinds.end())
+    {
+        return false;
+    }
+    if (mTargets.empty() || event.process.empty())
+    {
+        return true;
+    }
+    return std::any_of(mTargets.begin(), mTargets.end(), [&event] (const string & target) {
+        return ::fnmatch(target.c_str(), event.process.c_str(), 0) == 0 ||
+            ::fnmatch(target.c_str(), event.group.c_str(), 0) == 0;
+    });
+}
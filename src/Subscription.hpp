@@ -0,0 +1,53 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+using std::string;
+
+/*
+** something that happened to a process, or to the config, pushed to
+** the clients which subscribed on the control socket
+*/
+typedef struct Event {
+    // the new state (eg: RUNNING, see ProcessState.hpp), "exit", "reload",
+    // "rolling" (a rolling-restart ended), "promote" (a warm spare replaced
+    // a replica), "scale" (the autoscaler resized a program), "schedule"
+    // (a scheduled program was started), "job" (a job of a pool ended) or
+    // "idle" (a program was stopped after idle_timeout)
+    string kind;
+    // empty for config events
+    string process;
+    string group;
+    // the line sent to subscribers
+    string line;
+} Event;
+
+/*
+** what a subscriber wants to hear about, from its request:
+**   subscribe [target...] [--events kind,kind...]
+** targets are program or process names, or globs (eg: web_*), matched when the
+** event is published: processes created later are included. no target
+** means every process, no --events every kind. config events ignore targets.
+*/
+class Subscription {
+public:
+        /*
+        ** xtors
+        */
+        Subscription();
+        ~Subscription();
+
+        /*
+        ** business logic
+        */
+        static bool IsSubscribeRequest(const string & request);
+        int parse(const string & request, string & error);
+        bool matches(const Event & event) const;
+private:
+        /*
+        ** class members
+        */
+        std::vector<string> mTargets;
+        std::vector<string> mKinds;
+};
@@ -1,17 +1,34 @@
+#include "ControlServer.hpp"
+#include "Daemon.hpp"
+#include "MetricsServer.hpp"
 #include "Process.hpp"
+#include "ProgramSchema.hpp"
 #include "Supervisor.hpp"
 #include "Utils.hpp"
+#include "Validator.hpp"
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <csignal>
 #include <exception>
+#include <fnmatch.h>
 #include <functional>
 #include <memory>
+#include <poll.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/signal.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <thread>
+#include <iomanip>
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_set>
+#include <cstring>
 #include <unistd.h>
 #include <yaml-cpp/yaml.h>
 #include <ctime>
@@ -30,89 +47,101 @@ void SignalLambdaWrapper(int signal)
     sighup_handler(signal);
 }
 
-/*
-** Get node by value, check it's existence and return a
-** default constructed value if not found, as well as setting is_node_valid to false
-** you can pass initial_value as a parameter to find out if the read value is different
-*/
-template <typename T>
-[[nodiscard]]
-static auto GetYAMLNode(
-    const YAML::iterator &node,
-    const string &node_name,
-    const T& initial_value,
-    bool *is_node_valid,
-    bool *value_changed,
-    T default_value = T()) -> T
+// readline's callback interface takes a plain function
+std::function<void(char *)> line_handler;
+void LineHandlerWrapper(char *input)
 {
-    if (node->second[node_name])
-    {
-        T new_value = node->second[node_name].as<T>();
+    line_handler(input);
+}
 
-        if (new_value != initial_value)
-        {
-            *value_changed = true;
-        }
-        *is_node_valid = true;
-        return new_value;
+// SIGTERM, and SIGINT without a REPL
+std::function<void(int)> exit_handler;
+void ExitSignalWrapper(int signal)
+{
+    exit_handler(signal);
+}
+
+// readline's completion interface, called with each word to complete
+std::function<std::vector<string>(const string &, int)> completion_handler;
+std::vector<string> completions;
+char * CompletionGenerator(const char *text, int state)
+{
+    IGNORE(text);
+    static size_t next;
+
+    if (state == 0)
+    {
+        next = 0;
     }
-    return (default_value == T()) ? T() : default_value;
+    return (next < completions.size()) ? ::strdup(completions[next++].c_str()) : NULL;
 }
 
-/*
-** discard modification arguments
-*/
-template <typename T>
-[[nodiscard]]
-static auto GetYAMLNode(
-    const YAML::iterator &node,
-    const string &node_name,
-    bool *is_node_valid) -> T
+char ** CompletionWrapper(const char *text, int start, int end)
 {
-    bool useless_bool;
-    T useless_T = T();
-    return (GetYAMLNode(node, node_name, useless_T, is_node_valid, &useless_bool));
+    IGNORE(end);
+    // no fallback to file names
+    ::rl_attempted_completion_over = 1;
+    completions = completion_handler(text, start);
+    return ::rl_completion_matches(text, CompletionGenerator);
 }
 
+// how long the batch and the parent of a daemon wait for the boot, see waitForBoot
+const auto BootWaitLimit = 30s;
+// boot gives up on a launched program which is not ready BootReadySlack seconds
+//  past its start_time, or its ready_timeout (BootReadyLimit if not set)
+const double BootReadySlack = 1.0;
+const double BootReadyLimit = 30.0;
+
 static auto GetUniqueName(const string & base_name, int number) -> string
 {
     return base_name + "_" + std::to_string(number);
 }
 
-static auto SetProcessEnvironment(std::shared_ptr<Process>& new_process, YAML::Node env_vars, char **env_ptr) -> void
+static auto Seconds(double seconds) -> std::chrono::steady_clock::duration
 {
-    while (*env_ptr)
-    {
-        new_process->addAdditionalEnvValue(*env_ptr);
-        env_ptr++;
-    }
-    for (auto i : env_vars)
-    {
-        if (i.Type() != YAML::NodeType::Map)
-            break;
-        auto value_map = i.as<std::map<string, string> >();
-        for (auto & v : value_map)
-        {
-            new_process->addAdditionalEnvValue(v.first + "=" + v.second);
-        }
-    }
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
 }
 
-static auto AddMultipleProcessesToList(
-    int n_processes,
-    std::unordered_map<string, std::shared_ptr<Process>>& process_map,
-    std::shared_ptr<Process> new_process) -> void
+static auto WallTime() -> double
 {
-    auto initial_name = new_process->getProcessName();
-    process_map[new_process->getProcessName()] = new_process;
-    for (int i = 1; i <= n_processes; ++i)
-    {
-        auto name = GetUniqueName(initial_name, i);
-        auto copy_process = std::make_shared<Process>(Process(*new_process.get()));
-        copy_process->setProcessName(name);
-        process_map[name] = copy_process;
-    }
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// local time, to the second
+static auto FormatTime(double time) -> string
+{
+    time_t seconds = (time_t)time;
+    struct tm tm;
+    char buffer[32];
+
+    ::localtime_r(&seconds, &tm);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    return buffer;
+}
+
+// unix time, with milliseconds
+static auto EventTime() -> string
+{
+    auto now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << now;
+    return out.str();
+}
+
+static auto IsGlob(std::string_view pattern) -> bool
+{
+    return pattern.find_first_of("*?[") != std::string_view::npos;
+}
+
+// the replicas, then the spares
+static auto GroupProcesses(const ProcessGroup & group) -> ProcessList
+{
+    ProcessList processes(group.instances);
+
+    processes.insert(processes.end(), group.spares.begin(), group.spares.end());
+    return processes;
 }
+
 };
 
 Supervisor::Supervisor()
@@ -121,31 +150,54 @@ Supervisor::Supervisor()
 }
 
 Supervisor::Supervisor(
-    const string config_path,
-    const string log_file_path,
+    const SupervisorOptions & options,
     char *envp[]) :
       mIsConfigValid(false),
-      mConfigFilePath(config_path),
-      mInitialEnvironment(envp)
+      mOptions(options),
+      mBaseEnvironment(Environment::Intern(envp)),
+      mConfigLoader(options.configPath, options.configDir),
+      mRandom(std::random_device{}()),
+      mNextJobId(1),
+      mWakeFd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      mIsExiting(false),
+      mIsReloadRequested(false),
+      mStateVersion(0),
+      mNumberOfThreads(0)
 {
-    loadConfig(mConfigFilePath);
-    mLogFilePath = (log_file_path.empty()) ?
+    mLogFilePath = (options.logFilePath.empty()) ?
         "./taskmaster.log" :
-        log_file_path;
-    mLogFile.open(mLogFilePath, std::fstream::out);
+        options.logFilePath;
+    // a dry run leaves the log of a running taskmaster alone
+    if (!options.isDryRun)
+    {
+        mLogFile.open(mLogFilePath, std::fstream::out);
+    }
     Utils::LogStatus(mLogFile, "Starting taskmaster...\n");
+    registerMetrics();
+    if (!options.statusShmName.empty() && !options.isDryRun && mStatusTable.create(options.statusShmName) != 0)
+    {
+        Utils::LogError(mLogFile, options.statusShmName, string("status table: ") + std::strerror(errno));
+    }
+    loadConfig();
 }
 
 Supervisor::~Supervisor()
 {
+    stopServers();
     // make sure to stop all started programs if we exit the interpreter
-    this->exit(mProcessMap[""]);
+    ProcessList none;
+    this->exit(none, std::cout);
+    {
+        // threads are detached, they use the members until they return
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateCondition.wait(lock, [this] { return mNumberOfThreads == 0; });
+    }
     Utils::LogStatus(mLogFile, "Exiting taskmaster...\n");
     for (auto p : mProcessMap)
     {
         p.second.reset();
     }
-    ::exit(0);
+    ::close(mWakeFd);
 }
 
 [[nodiscard]]
@@ -154,26 +206,30 @@ int Supervisor::isConfigValid()
 
 void Supervisor::init()
 {
-    //start all processes that have exec_on_startup set to true
-    for (auto& [key, p]: mProcessMap)
-    {
-        if (p->getExecOnStartup() == false)
-        {
-            continue;
-        }
-        startProcess(p);
-    }
-
-    // init REPL
-    mCommandMap["help"]    = std::bind(&Supervisor::printHelp, this, std::placeholders::_1);
-    mCommandMap["reload"]  = std::bind(&Supervisor::reloadConfig, this, std::placeholders::_1);
-    mCommandMap["start"]   = std::bind(&Supervisor::startProcess, this, std::placeholders::_1);
-    mCommandMap["restart"] = std::bind(&Supervisor::restartProcess, this, std::placeholders::_1);
-    mCommandMap["stop"]    = std::bind(&Supervisor::stopProcess, this, std::placeholders::_1);
-    mCommandMap["status"]  = std::bind(&Supervisor::getProcessStatus, this, std::placeholders::_1);
-    mCommandMap["exit"]    = std::bind(&Supervisor::exit, this, std::placeholders::_1);
-    mCommandMap["history"] = std::bind(&Supervisor::history, this, std::placeholders::_1);
-    mCommandMap["list"]    = std::bind(&Supervisor::listProcesses, this, std::placeholders::_1);
+    // init REPL: the same commands serve the control socket and batch files
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    addCommand({.name = "help"}, std::bind(&Supervisor::printHelp, this, _1, _2));
+    addCommand({.name = "reload"}, std::bind(&Supervisor::reloadConfig, this, _1));
+    addCommand({.name = "start", .targets = TargetsRequired}, std::bind(&Supervisor::startProcesses, this, _1));
+    addCommand({.name = "restart", .targets = TargetsRequired}, std::bind(&Supervisor::restartProcesses, this, _1));
+    addCommand({.name = "rolling-restart", .minArgs = 1, .maxArgs = 1,
+        .options = {{"--batch", true}, {"--max-unavailable", true}, {"--timeout", true}}},
+        std::bind(&Supervisor::rollingRestart, this, _1, _2));
+    addCommand({.name = "stop", .targets = TargetsRequired}, std::bind(&Supervisor::stopProcesses, this, _1));
+    addCommand({.name = "status", .targets = TargetsDefaultAll,
+        .options = {{"--json"}, {"--tsv"}, {"--fields", true}, {"--where", true}}},
+        std::bind(&Supervisor::getProcessStatus, this, _1, _2));
+    addCommand({.name = "exit"}, std::bind(&Supervisor::exit, this, _1, _2));
+    addCommand({.name = "history"}, std::bind(&Supervisor::history, this, _1, _2));
+    addCommand({.name = "list", .maxArgs = 1}, std::bind(&Supervisor::listProcesses, this, _1, _2));
+    addCommand({.name = "validate"}, std::bind(&Supervisor::validate, this, _1, _2));
+    addCommand({.name = "push-metric", .minArgs = 2, .maxArgs = 2}, std::bind(&Supervisor::pushMetric, this, _1, _2));
+    addCommand({.name = "runs", .minArgs = 1, .maxArgs = 1}, std::bind(&Supervisor::runs, this, _1, _2));
+    addCommand({.name = "submit", .minArgs = 1, .maxArgs = 256, .options = {{"--env", true}}},
+        std::bind(&Supervisor::submit, this, _1, _2));
+    addCommand({.name = "jobs", .minArgs = 1, .maxArgs = 1}, std::bind(&Supervisor::jobs, this, _1, _2));
+    addCommand({.name = "boot-report"}, std::bind(&Supervisor::bootReport, this, _1, _2));
 
     // add signal to reload config
     struct sigaction shup_handler;
@@ -182,470 +238,3049 @@ void Supervisor::init()
     shup_handler.sa_flags = SA_RESTART;
     sigaction(SIGHUP, &shup_handler, NULL);
 
-    sighup_handler = [&] (int signal) {
+    // the reload itself runs on the main thread, see wakeUp()
+    sighup_handler = [this] (int signal) {
         IGNORE(signal);
-        reloadConfig(mProcessMap[""]);
+        uint64_t one = 1;
+        mIsReloadRequested = true;
+        IGNORE(::write(mWakeFd, &one, sizeof(one)))
     };
 
-    // start REPL
-    for (;;)
+    // stop gracefully instead of leaving the programs behind
+    struct sigaction exit_signal_handler;
+    sigemptyset(&exit_signal_handler.sa_mask);
+    exit_signal_handler.sa_handler = ExitSignalWrapper;
+    exit_signal_handler.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &exit_signal_handler, NULL);
+    if (!mOptions.isInteractive)
     {
-        bool found_command = false;
-        char* input = ::readline("taskmasterctl>$ ");
-        string line;
-        if (!input)
+        sigaction(SIGINT, &exit_signal_handler, NULL);
+    }
+
+    // only async-signal-safe work: an atomic store and a write
+    exit_handler = [this] (int signal) {
+        IGNORE(signal);
+        requestExit();
+    };
+
+    // before anything starts, so that subscribers can see it
+    if (startServers() != 0)
+    {
+        return ;
+    }
+
+    //start all programs that have exec_on_startup set to true, after their dependencies
+    std::vector<string> on_startup;
+    for (auto & [name, group] : mGroupMap)
+    {
+        if (group.spec->execOnStartup || group.spec->lazyStart)
         {
-            // readline sets input to nullptr upon receiving a 
-            //  signal
-            if (sig_test)
-            {
-                std::cout << "\n";
-                sig_test = false;
-                continue;
-            }
-            return ;
+            on_startup.push_back(name);
         }
-        line = input;
-        add_history(input);
-        auto split_command = Utils::SplitString(line, " ");
-        if (split_command.size() == 0)
-        {
-            continue ;
-        }
-        for (auto it = mCommandMap.begin(); it != mCommandMap.end(); ++it)
-        {
-            if ((*it).first == split_command.front())
-            {
-                if (mProcessMap.find(split_command.back()) != mProcessMap.end() ||
-                    split_command.front() == "help" ||
-                    split_command.front() == "reload" ||
-                    split_command.front() == "status" ||
-                    split_command.front() == "list" ||
-                    split_command.front() == "exit" ||
-                    split_command.front() == "history") {
-                    mCommandMap[(*it).first](mProcessMap[split_command.back()]);
-                    found_command = true;
-                    if (split_command.front() == "exit")
-                    {
-                        return ;
-                    }
-                }
-            }
+    }
+    // on a thread of its own: the REPL and the control socket are served meanwhile
+    detach([this, on_startup] { startInOrder(on_startup); });
+    for (auto & [name, group] : mGroupMap)
+    {
+        if (!group.spec->autoscaleMetric.empty())
+        {
+            armAutoscale(group.spec);
         }
-        if (!found_command)
+        if (!group.spec->schedule.empty())
         {
-            std::cout << "Command not found: " << line << "\n";
+            armSchedule(group.spec);
         }
-        if (input)
+        // lazy_start ones are watched once their dependencies are ready
+        if (group.spec->idleTimeout > 0.0 && !group.spec->lazyStart)
         {
-            free(input);
+            armSocketWatch(group.spec);
         }
     }
+
+    // the batch runs, and the parent of a daemon exits, once everything is started
+    if (!mOptions.batchPath.empty() || mOptions.readyFd != -1)
+    {
+        waitForBoot();
+    }
+    if (!mOptions.batchPath.empty())
+    {
+        runBatch(mOptions.batchPath);
+    }
+    Daemon::Ready(mOptions.readyFd);
+    if (mOptions.isInteractive)
+    {
+        runInterpreter();
+    }
+    else
+    {
+        waitForExit();
+    }
 }
 
 /*
-** call _start in another thread and allow the user back into the REPL.
-** return value is discarded.
+** execute the commands of a file, one per line, as fast as they go:
+** blank lines and lines starting with '#' are skipped, a failing command is
+** reported and the next one runs. "-" reads stdin.
+** returns the number of failed commands.
 */
-int Supervisor::startProcess(std::shared_ptr<Process> & process)
+int Supervisor::runBatch(const string & path)
 {
-    if (process->isAlive())
+    std::ifstream file;
+    std::istream *in = &std::cin;
+    string line;
+    size_t n_commands = 0, n_failed = 0, line_number = 0;
+    auto begin = std::chrono::steady_clock::now();
+
+    if (path != "-")
     {
-        return 0;
+        file.open(path);
+        if (!file.is_open())
+        {
+            Utils::LogError(mLogFile, path, string("batch: ") + std::strerror(errno));
+            std::cerr << "error: batch " << path << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        in = &file;
     }
-    std::thread start_thread(&Supervisor::_start, this, std::ref(process));
-    start_thread.detach();
-    return 0;
-}
-
-int Supervisor::restartProcess(std::shared_ptr<Process> & process)
-{
-    if (!process->isAlive())
+    while (!mIsExiting && std::getline(*in, line))
     {
-        startProcess(process);
-        return 0;
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        ++n_commands;
+        if (executeCommand(line.substr(first), std::cout) != 0)
+        {
+            ++n_failed;
+            Utils::LogError(mLogFile, path + ":" + std::to_string(line_number), "batch: failed: " + line);
+            std::cerr << "error: " << path << ":" << line_number << ": " << line << "\n";
+        }
     }
-    stopProcess(process);
-    startProcess(process);
-    return 0;
+    std::ostringstream summary;
+    summary << "Batch " << path << ": " << n_commands << " commands, " << n_failed << " failed, in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() << "s\n";
+    Utils::LogStatus(mLogFile, summary.str());
+    std::cout << summary.str();
+    return n_failed;
 }
 
-
 /*
-** start and/or restart processes
+** the REPL, on the terminal
 */
-void Supervisor::_start(std::shared_ptr<Process> & process)
+void Supervisor::runInterpreter()
 {
-    int number_of_restarts = (process->getShouldRestart() != 0) ?
-        process->getNumberOfRestarts() :
-        1;
-
-    // restart n times if 
-    auto i = 0;
-    while (i < number_of_restarts)
-    {
-        process->start();
-        if (!process->isAlive())
+    // start REPL
+    line_handler = [this] (char *input) {
+        if (!input)
         {
-            Utils::LogError(
-                mLogFile,
-                process->getProcessName(),
-                "Did not start. strerror: " + process->getStrerror());
+            // end of input: same as exit
+            std::cout << "\n";
+            executeCommand("exit", std::cout);
+            return ;
         }
+        string line = input;
+        add_history(input);
+        free(input);
+        executeCommand(line, std::cout);
+    };
+    completion_handler = [this] (const string & text, int start) {
+        return complete(string(::rl_line_buffer, start), text);
+    };
+    ::rl_attempted_completion_function = CompletionWrapper;
+    ::rl_callback_handler_install("taskmasterctl>$ ", LineHandlerWrapper);
 
-        // the process managed to start, monitor it until it ends
-        int ret = _monitor(process);
-        switch (process->getShouldRestart())
+    // wait for input, or for an exit requested from the control socket
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {mWakeFd, POLLIN, 0}};
+    while (!mIsExiting)
+    {
+        if (::poll(fds, 2, -1) == -1 || (fds[1].revents && wakeUp()))
         {
-        case ShouldRestart::Never:
-            return ;
-        case ShouldRestart::Always:
-            continue;
-        case ShouldRestart::UnexpectedExit:
-            if (ret != 0)
+            // readline still needs a new prompt after a signal (eg: SIGHUP)
+            if (sig_test)
             {
-                // restart if there was an error
-                ++i;
-                continue;
+                sig_test = false;
+                ::rl_on_new_line();
+                ::rl_redisplay();
             }
-            return ;
-        default:
-            Utils::LogError(
-                mLogFile,
-                process->getProcessName(),
-                "Invalid should_restart value provided. Exiting.");
-            return ;
+            continue;
+        }
+        if (fds[0].revents)
+        {
+            ::rl_callback_read_char();
         }
     }
-    return ;
+    ::rl_callback_handler_remove();
 }
 
-[[nodiscard]]
-int Supervisor::_monitor(std::shared_ptr<Process>& process)
+/*
+** no REPL (--daemon, --foreground): commands only come from the control
+** socket, SIGTERM and SIGINT stop taskmaster, SIGHUP reloads
+*/
+void Supervisor::waitForExit()
 {
-    int ret = 0;
-    bool has_error = false;
+    struct pollfd fd = {mWakeFd, POLLIN, 0};
 
-    waitpid(process->getPid(), &ret, 0);
-    process->setIsAlive(false);
-    if (WIFEXITED(ret))
+    if (!mIsExiting)
     {
-        process->setReturnValue(WEXITSTATUS(ret));
+        Utils::LogStatus(mLogFile, "Running without a REPL, pid " + std::to_string(::getpid()) + "\n");
     }
-    else if (WIFSIGNALED(ret))
+    while (!mIsExiting)
     {
-        Utils::LogStatus(
-            mLogFile,
-            "Process " + process->getProcessName() +
-            " killed by signal: " + std::to_string(WTERMSIG(ret)) + "\n");
+        if (::poll(&fd, 1, -1) > 0)
+        {
+            wakeUp();
+        }
     }
+}
 
-    // if a start_time was set in config, we need to make sure that we did not return 
-    //  too early by doing current ?> exec_time + start_time
-    if (process->getStartTime() != 0.0 &&
-        std::time(nullptr) < (process->getExecTime() + process->getStartTime()))
-    {
-        Utils::LogError(
-            mLogFile,
-            process->getProcessName(),
-            "Returned too early.");
-        has_error = true;
-    }
-    if (!process->isExpectedReturnValue(process->getReturnValue()))
-    {
-        Utils::LogError(
-            mLogFile,
-            process->getProcessName(),
-            "Unexpected return value: " + std::to_string(process->getReturnValue()) +
-            " expected: " + std::to_string(process->getExpectedReturnValues().front()));
-        has_error = true;
-    }
-    if (!has_error)
-    {
-        Utils::LogSuccess(
-            mLogFile,
-            process->getProcessName(),
-            "Terminated without errors.");
-    }
-    else 
+/*
+** the main thread was woken up: run a reload requested by SIGHUP.
+** returns true if it did.
+*/
+bool Supervisor::wakeUp()
+{
+    uint64_t count;
+
+    IGNORE(::read(mWakeFd, &count, sizeof(count)))
+    if (mIsExiting || !mIsReloadRequested.exchange(false))
     {
-        Utils::LogError(
-            mLogFile,
-            process->getProcessName(),
-            "Encountered problems.");
+        return false;
     }
-    return has_error;
+    std::ostringstream out;
+    executeCommand("reload", out);
+    return true;
 }
 
-[[nodiscard]]
-int Supervisor::stopProcess(std::shared_ptr<Process> & process)
+/*
+** candidates for the word being typed: commands first, then the options of
+** the command, or names (see NameIndex) for commands which take targets
+*/
+std::vector<string> Supervisor::complete(const string & before, const string & word)
 {
-    int stop_return_val = 0;
+    std::vector<string> out;
+    std::vector<std::string_view> words;
+    string storage, error;
 
-    stop_return_val = process->stop();
-    if (stop_return_val == -1)
+    if (CommandParser::Tokenize(before, words, storage, error) != 0)
     {
-        Utils::LogError(mLogFile, process->getProcessName(), "is not running.");
+        return out;
     }
-    else if (stop_return_val == 1)
+    // the command table is not modified once the REPL runs
+    if (words.empty())
     {
-        // should we wait and force kill ?
-        Utils::LogError(mLogFile, process->getProcessName(), 
-            "kill(" + std::to_string(process->getKillSignal()) + ") did not return as expected. Force quitting (using SIGKILL).");
-        std::this_thread::sleep_for(std::chrono::duration<double>(process->getForceQuitWaitTime()));
-        process->kill();
-    }
-    else
-    {
-        Utils::LogSuccess(mLogFile, process->getProcessName(), "Terminated.");
+        for (auto & command : mCommandParser.getCommands())
+        {
+            if (command.name.compare(0, word.size(), word) == 0)
+            {
+                out.push_back(command.name);
+            }
+        }
+        return out;
     }
-    return 0;
-}
-
-int Supervisor::getProcessStatus(std::shared_ptr<Process> & process)
-{
-    if (process.get() != nullptr)
+    const CommandSpec *command = mCommandParser.find(words.front());
+    if (command == nullptr)
     {
-        std::cout << *process.get() << "\n";
+        return out;
     }
-    else
+    if (word.compare(0, 2, "--") == 0)
     {
-        for (auto & [key, proc]: mProcessMap)
+        for (auto & option : command->options)
         {
-            if (proc.get() != nullptr)
+            if (option.name.compare(0, word.size(), word) == 0)
             {
-                std::cout << *proc.get() << "\n";
+                out.push_back(option.name);
             }
         }
+        return out;
     }
-    return 0;
-}
-
-int Supervisor::printHelp(std::shared_ptr<Process> & process)
-{
-    IGNORE(process);
-    string out;
-    out += "=========Taskmaster========\n";
-    out += "----available commands:----\n";
-    out += "help          : Print this help\n";
-    out += "reload        : reload config file (" + mConfigFilePath + ")\n";
-    out += "start  <name> : Start process by name\n";
-    out += "status <name> : get status of program \n";
-    out += "history       : command history\n";
-    out += "exit          : terminate all programs and exit\n";
-    std::cout << out;
-    return 0;
+    if (command->targets != TargetsNone)
+    {
+        if (string("all").compare(0, word.size(), word) == 0)
+        {
+            out.push_back("all");
+        }
+        mNameIndex.find(word, out);
+    }
+    return out;
 }
 
 /*
-** reload process configuration, or, if no process is specified,
-**  reload full config
+** parse and run a command line, writing its output to out.
+** used by the REPL and the control socket; commands never run concurrently.
+** returns 1 if the command was not found.
 */
-int Supervisor::reloadConfig(std::shared_ptr<Process> & process)
+int Supervisor::executeCommand(const string & line, std::ostream & out)
 {
-    IGNORE(process);
-    return loadConfig(mConfigFilePath, true);
+    static const std::vector<std::string_view> all = {"all"};
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    ProcessList targets;
+    string error;
+
+    if (mCommandParser.parse(line, error) != 0)
+    {
+        out << error << "\n";
+        return 1;
+    }
+    const CommandSpec *command = mCommandParser.getCommand();
+    if (command == nullptr)
+    {
+        return 0;
+    }
+    if (command->targets != TargetsNone)
+    {
+        auto & args = mCommandParser.getArgs();
+        if (resolveTargets(args.empty() ? all : args, targets, out) != 0)
+        {
+            return 1;
+        }
+    }
+    auto begin = std::chrono::steady_clock::now();
+    int ret = mCommandHandlers[command->id](targets, out);
+    mMetrics.commands->inc();
+    mMetrics.commandDuration->observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    if (command->name == "exit")
+    {
+        requestExit();
+    }
+    return ret;
 }
 
-int Supervisor::exit(std::shared_ptr<Process>& process)
+void Supervisor::addCommand(const CommandSpec & spec, const CommandHandler & handler)
 {
-    IGNORE(process);
+    size_t id = mCommandParser.add(spec);
 
-    std::cout.flush();
-    int n = killAllProcesses();
-    Utils::LogStatus(mLogFile, "Killed: " + std::to_string(n) + " processe(s);\n");
-    return 0;
+    mCommandHandlers.resize(id + 1);
+    mCommandHandlers[id] = handler;
 }
 
-int Supervisor::history(std::shared_ptr<Process>& process)
+/*
+** expand command arguments to processes, in order and without duplicates.
+** an argument is "all", a group (every replica of a program), a process name,
+** or a glob matched against both (eg: web_*)
+*/
+int Supervisor::resolveTargets(const std::vector<std::string_view> & args, ProcessList & targets, std::ostream & out)
 {
-    IGNORE(process);
-    string out =
-        "==== taskmaster command history ====\n";
+    std::unordered_set<const Process *> seen;
+    int ret = 0;
 
-    HIST_ENTRY** history_entry_list = history_list();
-    if (history_entry_list)
-    {
-        for (int i = 0; history_entry_list[i] != nullptr; i++)
+    auto add = [&] (const std::shared_ptr<Process> & process) {
+        if (seen.insert(process.get()).second)
+        {
+            targets.push_back(process);
+        }
+    };
+    auto add_group = [&] (const ProcessGroup & group) {
+        for (auto & process : GroupProcesses(group))
+        {
+            add(process);
+        }
+    };
+    // "all" and globs go through the names in order
+    auto sorted_names = [] (const auto & map) {
+        std::vector<const string *> names;
+        names.reserve(map.size());
+        for (auto & entry : map)
+        {
+            names.push_back(&entry.first);
+        }
+        std::sort(names.begin(), names.end(), [] (const string *a, const string *b) { return *a < *b; });
+        return names;
+    };
+
+    for (auto arg_view : args)
+    {
+        string arg(arg_view);
+        size_t n_targets = targets.size();
+        auto group = mGroupMap.find(arg);
+        auto process = mProcessMap.find(arg);
+        bool is_name = group != mGroupMap.end() || (process != mProcessMap.end() && process->second);
+
+        if (arg == "all")
+        {
+            for (auto name : sorted_names(mGroupMap))
+            {
+                add_group(mGroupMap[*name]);
+            }
+        }
+        else if (group != mGroupMap.end())
+        {
+            add_group(group->second);
+        }
+        else if (process != mProcessMap.end() && process->second)
+        {
+            add(process->second);
+        }
+        else if (IsGlob(arg))
+        {
+            for (auto name : sorted_names(mGroupMap))
+            {
+                if (::fnmatch(arg.c_str(), name->c_str(), 0) == 0)
+                {
+                    add_group(mGroupMap[*name]);
+                }
+            }
+            for (auto name : sorted_names(mProcessMap))
+            {
+                if (mProcessMap[*name] && ::fnmatch(arg.c_str(), name->c_str(), 0) == 0)
+                {
+                    add(mProcessMap[*name]);
+                }
+            }
+        }
+        // names which were already added are not an error
+        if (targets.size() == n_targets && arg != "all" && !is_name)
+        {
+            out << "No such process or group: " << arg << "\n";
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+/*
+** wake the REPL up so init() returns
+*/
+void Supervisor::requestExit()
+{
+    uint64_t one = 1;
+
+    mIsExiting = true;
+    IGNORE(::write(mWakeFd, &one, sizeof(one)))
+}
+
+/*
+** serve commands on the control socket and metrics, from the event loop thread
+*/
+int Supervisor::startServers()
+{
+    if (!mOptions.socketPath.empty())
+    {
+        auto server = std::make_unique<ControlServer>(mEventLoop, mOptions.socketPath,
+            [this] (const string & request, string & response) {
+                std::ostringstream out;
+                int ret = executeCommand(request, out);
+                response = out.str();
+                return ret;
+            });
+        if (server->start() != 0)
+        {
+            Utils::LogError(mLogFile, mOptions.socketPath, string("control socket: ") + std::strerror(errno));
+            std::cerr << "error: control socket " << mOptions.socketPath << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mEventMutex);
+            mControlServer = std::move(server);
+        }
+        Utils::LogStatus(mLogFile, "Control socket listening on " + mOptions.socketPath + "\n");
+    }
+    if (!mOptions.metricsAddress.empty())
+    {
+        auto server = std::make_unique<MetricsServer>(mEventLoop, mOptions.metricsAddress, mMetricsRegistry);
+        if (server->start() != 0)
+        {
+            Utils::LogError(mLogFile, mOptions.metricsAddress, string("metrics: ") + std::strerror(errno));
+            std::cerr << "error: metrics " << mOptions.metricsAddress << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        mMetricsServer = std::move(server);
+        Utils::LogStatus(mLogFile, "Metrics served on " + mOptions.metricsAddress + "\n");
+    }
+    // also watches the sockets of lazy_start and idle_timeout programs
+    mEventLoopThread = std::thread(&EventLoop::run, &mEventLoop);
+    return 0;
+}
+
+void Supervisor::stopServers()
+{
+    std::unique_ptr<ControlServer> server;
+
+    {
+        std::lock_guard<std::mutex> lock(mEventMutex);
+        server = std::move(mControlServer);
+    }
+    if (server)
+    {
+        server->stop();
+    }
+    if (mEventLoopThread.joinable())
+    {
+        mEventLoop.stop();
+        mEventLoopThread.join();
+    }
+    mMetricsServer.reset();
+}
+
+/*
+** created before the config is loaded: every metric exists from the start
+*/
+void Supervisor::registerMetrics()
+{
+    std::vector<string> codes, signals, states;
+
+    for (int i = 0; i < 256; ++i)
+    {
+        codes.push_back(std::to_string(i));
+    }
+    for (int i = 0; i < NSIG; ++i)
+    {
+        signals.push_back(std::to_string(i));
+    }
+    for (int i = 0; i < NumberOfStates; ++i)
+    {
+        states.push_back(ProcessStateName(i));
+    }
+    mMetrics.spawns = mMetricsRegistry.counter("taskmaster_spawns_total",
+        "Processes started.");
+    mMetrics.spawnFailures = mMetricsRegistry.counter("taskmaster_spawn_failures_total",
+        "Processes which could not be started (fork, redirection, chdir or execve failed).");
+    mMetrics.spawnLatency = mMetricsRegistry.histogram("taskmaster_spawn_latency_seconds",
+        "Time from fork to a successful execve.");
+    mMetrics.readyLatency = mMetricsRegistry.histogram("taskmaster_ready_latency_seconds",
+        "Time from execve to READY (ready_fd notification, or start_time).");
+    mMetrics.readyTimeouts = mMetricsRegistry.counter("taskmaster_ready_timeouts_total",
+        "Processes stopped for not being ready within ready_timeout.");
+    mMetrics.exitCodes = mMetricsRegistry.family("taskmaster_exits_total",
+        "Processes which exited, by exit code.", "counter", "code", codes);
+    mMetrics.exitSignals = mMetricsRegistry.family("taskmaster_exits_by_signal_total",
+        "Processes killed by a signal, by signal number.", "counter", "signal", signals);
+    mMetrics.restarts = mMetricsRegistry.counter("taskmaster_restarts_total",
+        "Processes restarted after they exited (should_restart).");
+    mMetrics.backoffs = mMetricsRegistry.counter("taskmaster_backoffs_total",
+        "Times a process went through BACKOFF before a restart.");
+    mMetrics.promotions = mMetricsRegistry.counter("taskmaster_spare_promotions_total",
+        "Replicas replaced by a warm spare after they exited (warm_spares).");
+    mMetrics.autoscales = mMetricsRegistry.counter("taskmaster_autoscale_changes_total",
+        "Replica counts changed by the autoscaler (autoscale_metric).");
+    mMetrics.jobsSubmitted = mMetricsRegistry.counter("taskmaster_jobs_submitted_total",
+        "Jobs queued in a job pool (submit).");
+    mMetrics.jobsRejected = mMetricsRegistry.counter("taskmaster_jobs_rejected_total",
+        "Jobs rejected because the queue of their pool was full (job_queue_size).");
+    mMetrics.jobWait = mMetricsRegistry.histogram("taskmaster_job_wait_seconds",
+        "Time from the submission of a job to its start.");
+    mMetrics.stopLatency = mMetricsRegistry.histogram("taskmaster_stop_latency_seconds",
+        "Time from the stop signal to the exit of a process.");
+    mMetrics.reloadDuration = mMetricsRegistry.histogram("taskmaster_reload_duration_seconds",
+        "Time taken by a config reload.");
+    mMetrics.commands = mMetricsRegistry.counter("taskmaster_commands_total",
+        "Commands run, from the REPL or the control socket.");
+    mMetrics.commandDuration = mMetricsRegistry.histogram("taskmaster_command_duration_seconds",
+        "Time taken by a command.");
+    mMetrics.processes = mMetricsRegistry.family("taskmaster_processes",
+        "Processes, by state.", "gauge", "state", states);
+    // read on the loop thread, where the control server lives
+    mMetricsRegistry.collector("taskmaster_control_clients",
+        "Clients connected to the control socket.", "gauge", [this] {
+            std::lock_guard<std::mutex> lock(mEventMutex);
+            return (mControlServer) ? (double)mControlServer->getNumberOfClients() : 0.0;
+        });
+    mMetricsRegistry.collector("taskmaster_subscribers_dropped_total",
+        "Event subscribers disconnected for not reading fast enough.", "counter", [this] {
+            std::lock_guard<std::mutex> lock(mEventMutex);
+            return (mControlServer) ? (double)mControlServer->getNumberOfDroppedSubscribers() : 0.0;
+        });
+}
+
+/*
+** hand an event to the control socket's subscribers, if it is served
+*/
+void Supervisor::emitEvent(const string & kind, const Process * process, const string & details)
+{
+    Event event;
+
+    event.kind = kind;
+    if (process)
+    {
+        event.process = process->getProcessName();
+        event.group = process->getSpec()->name;
+    }
+    event.line = EventTime() + " " + ((process) ? event.process + " " + event.group + " " : "") + details;
+    std::lock_guard<std::mutex> lock(mEventMutex);
+    if (mControlServer)
+    {
+        mControlServer->publish(event);
+    }
+}
+
+/*
+** call _start in another thread and allow the user back into the REPL.
+** return value is discarded.
+*/
+int Supervisor::startProcess(std::shared_ptr<Process> & process)
+{
+    // nothing starts once everything is being stopped, nor twice while alive
+    uint64_t run = (mIsExiting) ? 0 : process->beginRun();
+    if (run == 0)
+    {
+        return 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        ++mRunThreads[process.get()];
+    }
+    detach([this, process, run] {
+        _start(process, run);
+        onRunEnd(process);
+        leaveRun(process);
+    });
+    return 0;
+}
+
+/*
+** last thing a _start thread does: nothing touches the process after this,
+** a retired one can give its status slot back
+*/
+void Supervisor::leaveRun(const std::shared_ptr<Process> & process)
+{
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    auto it = mRunThreads.find(process.get());
+
+    if (--it->second > 0)
+    {
+        return ;
+    }
+    mRunThreads.erase(it);
+    auto retired = std::find(mRetiredProcesses.begin(), mRetiredProcesses.end(), process);
+    if (retired != mRetiredProcesses.end())
+    {
+        mStatusTable.release(process->getStatusSlot());
+        mMetrics.processes->add(process->getState(), -1);
+        mRetiredProcesses.erase(retired);
+    }
+}
+
+/*
+** a process removed from its group. its run was ended, but its _start thread
+** may still be on the way out and set its state: the status slot and the
+** gauge are only released once that thread is done.
+*/
+void Supervisor::retireProcess(const std::shared_ptr<Process> & process)
+{
+    std::lock_guard<std::mutex> lock(mStateMutex);
+
+    if (mRunThreads.contains(process.get()))
+    {
+        mRetiredProcesses.push_back(process);
+        return ;
+    }
+    mStatusTable.release(process->getStatusSlot());
+    mMetrics.processes->add(process->getState(), -1);
+}
+
+/*
+** run a task in a thread of its own, which the destructor waits for
+*/
+void Supervisor::detach(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        ++mNumberOfThreads;
+    }
+    std::thread thread([this, task] {
+        task();
+        // notified under the lock: the destructor may be waiting for this one
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        --mNumberOfThreads;
+        mStateCondition.notify_all();
+    });
+    thread.detach();
+}
+
+int Supervisor::startProcesses(ProcessList & processes)
+{
+    for (auto & process : processes)
+    {
+        startProcess(process);
+    }
+    return 0;
+}
+
+/*
+** start programs, and everything they depend on, each one as soon as its
+** dependencies are ready: boot takes as long as the longest chain of
+** dependencies, unrelated programs start concurrently. a program whose
+** dependency failed is not started.
+**
+** programs are started by priority class, lowest first: a class starts
+** once every program of the previous one is ready (or failed), or once the
+** window of the previous one expired. the launches of a class are spread
+** evenly across its window. a program is in the class of its priority, or
+** in a later one with the programs it depends on.
+**
+** a launched program which is not ready once its start_time, or ready_timeout,
+** and BootReadySlack elapsed is not waited for anymore: it fails its boot,
+** so that its class, and the ones after it, are never held forever.
+*/
+void Supervisor::startInOrder(const std::vector<string> & programs)
+{
+    std::unique_lock<std::mutex> command_lock(mCommandMutex);
+    std::vector<string> pending = mDependencyGraph.closure(programs);
+    std::unordered_map<string, int> status;
+    std::unordered_set<string> started;
+    auto begin = std::chrono::steady_clock::now();
+    size_t n_programs = pending.size();
+    std::map<int, std::vector<string> > classes;
+    std::unordered_map<string, int> priorities;
+    // seconds from launch to give up on a program, see BootReadySlack
+    std::unordered_map<string, double> limits;
+    // in boot.programs and boot.classes, by program
+    std::unordered_map<string, std::pair<size_t, size_t> > places;
+    BootReport boot;
+    size_t n_open = 0;
+    // a program was ready or failed: the next class may start right away
+    bool is_changed = false;
+
+    // removed by a reload since
+    std::erase_if(pending, [this] (const string & name) { return !mGroupMap.contains(name); });
+    n_programs = pending.size();
+    // the lowest levels first, so that independent programs start right away
+    std::sort(pending.begin(), pending.end(), [this] (const string & a, const string & b) {
+        return mDependencyGraph.getLevel(a) < mDependencyGraph.getLevel(b);
+    });
+    // dependencies come first: their class is known
+    for (auto & name : pending)
+    {
+        const ProgramSpec & spec = *mGroupMap.find(name)->second.spec;
+        int priority = spec.priority;
+        double wait = (spec.readyFd == -1) ? (double)spec.startTime :
+            (spec.readyTimeout > 0.0) ? spec.readyTimeout : BootReadyLimit;
+        limits[name] = wait + BootReadySlack;
+        for (auto & dependency : mDependencyGraph.getDependencies(name))
+        {
+            auto dependency_priority = priorities.find(dependency);
+            if (dependency_priority != priorities.end())
+            {
+                priority = std::max(priority, dependency_priority->second);
+            }
+        }
+        priorities[name] = priority;
+        classes[priority].push_back(name);
+    }
+    for (auto & [priority, names] : classes)
+    {
+        double window = 0.0;
+        for (auto & name : names)
+        {
+            window = std::max(window, mGroupMap.find(name)->second.spec->startDelay);
+        }
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            places[names[i]] = {boot.programs.size(), boot.classes.size()};
+            boot.programs.push_back({names[i], priority, window * i / names.size(), -1.0, -1.0, 0, ""});
+        }
+        boot.classes.push_back({priority, window, -1.0, -1.0, ""});
+    }
+    command_lock.unlock();
+    auto finish = [&] (const string & name, int ready, double now, const string & note) {
+        BootProgram & program = boot.programs[places[name].first];
+        status[name] = ready;
+        is_changed = true;
+        program.status = ready;
+        program.done = now;
+        program.note = note;
+    };
+
+    while (!pending.empty() && !mIsExiting)
+    {
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            version = mStateVersion;
+        }
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        is_changed = false;
+        // the next class, once this one is ready or its window expired
+        while (n_open < boot.classes.size())
+        {
+            if (n_open > 0)
+            {
+                BootClass & current = boot.classes[n_open - 1];
+                auto & names = classes[current.priority];
+                bool is_ready = std::all_of(names.begin(), names.end(),
+                    [&status](const string & name) { return status.count(name) != 0; });
+                bool is_expired = current.window > 0.0 && now >= current.opened + current.window;
+                if (!is_ready && !is_expired)
+                {
+                    break;
+                }
+                current.closed = now;
+                current.reason = (is_ready) ? "ready" : "window expired";
+            }
+            BootClass & next = boot.classes[n_open++];
+            next.opened = now;
+            if (boot.classes.size() > 1 || next.window > 0.0)
+            {
+                std::ostringstream message;
+                message << "priority " << next.priority << ": starting " << classes[next.priority].size()
+                        << " program(s) over " << next.window << "s\n";
+                Utils::LogStatus(mLogFile, message.str());
+            }
+        }
+        // until a state changes, the next launch or the end of a window
+        double wait = 0.1;
+        if (boot.classes[n_open - 1].window > 0.0 && n_open < boot.classes.size())
+        {
+            wait = std::min(wait, boot.classes[n_open - 1].opened + boot.classes[n_open - 1].window - now);
+        }
+
+        // the groups may be reloaded or resized meanwhile: only looked up under the lock
+        command_lock.lock();
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            const string & name = *it;
+            BootProgram & program = boot.programs[places[name].first];
+            const BootClass & program_class = boot.classes[places[name].second];
+            auto group_it = mGroupMap.find(name);
+            if (group_it == mGroupMap.end())
+            {
+                finish(name, -1, now, "removed from the config");
+                it = pending.erase(it);
+                continue;
+            }
+            if (started.count(name))
+            {
+                int ready = programReadiness(name);
+                if (ready != 0)
+                {
+                    finish(name, ready, now, "");
+                    it = pending.erase(it);
+                    continue;
+                }
+                if (now >= program.launched + limits[name])
+                {
+                    std::ostringstream note;
+                    note << "not ready after " << limits[name] << "s";
+                    Utils::LogError(mLogFile, name, note.str() + ", boot goes on without it");
+                    finish(name, -1, now, note.str());
+                    it = pending.erase(it);
+                    continue;
+                }
+                wait = std::min(wait, program.launched + limits[name] - now);
+                ++it;
+                continue;
+            }
+            // its class did not start yet, or its launch is not due
+            if (places[name].second >= n_open || now < program_class.opened + program.offset)
+            {
+                if (places[name].second < n_open)
+                {
+                    wait = std::min(wait, program_class.opened + program.offset - now);
+                }
+                ++it;
+                continue;
+            }
+            const string *failed = nullptr;
+            bool is_ready = true;
+            for (auto & dependency : mDependencyGraph.getDependencies(name))
+            {
+                auto dependency_status = status.find(dependency);
+                is_ready = is_ready && dependency_status != status.end() && dependency_status->second == 1;
+                if (dependency_status != status.end() && dependency_status->second == -1)
+                {
+                    failed = &dependency;
+                }
+            }
+            if (failed)
+            {
+                Utils::LogError(mLogFile, name, "not started: dependency " + *failed + " failed");
+                finish(name, -1, now, "dependency " + *failed + " failed");
+                it = pending.erase(it);
+                continue;
+            }
+            if (is_ready && group_it->second.spec->lazyStart)
+            {
+                // ready once it listens: connections wait in the backlog
+                armSocketWatch(group_it->second.spec);
+                program.launched = now;
+                finish(name, 1, now, "waits for a connection");
+                it = pending.erase(it);
+                continue;
+            }
+            if (is_ready)
+            {
+                for (auto & process : GroupProcesses(group_it->second))
+                {
+                    startProcess(process);
+                }
+                started.insert(name);
+                program.launched = now;
+            }
+            ++it;
+        }
+        command_lock.unlock();
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            mBootReport = boot;
+        }
+        if (pending.empty())
+        {
+            break;
+        }
+        if (is_changed)
+        {
+            continue;
+        }
+        // the timeout also checks for exit
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateCondition.wait_for(lock, Seconds(std::max(wait, 0.0)),
+            [this, version] { return mStateVersion != version; });
+    }
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    for (auto & boot_class : boot.classes)
+    {
+        if (boot_class.opened >= 0.0 && boot_class.closed < 0.0)
+        {
+            boot_class.closed = duration;
+            boot_class.reason = "ready";
+        }
+    }
+    boot.duration = duration;
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mBootReport = boot;
+    }
+    // see waitForBoot
+    mStateCondition.notify_all();
+    std::ostringstream summary;
+    summary << "Started " << n_programs << " program(s) in " << duration << "s\n";
+    Utils::LogStatus(mLogFile, summary.str());
+}
+
+/*
+** wait for startInOrder to be done, at most BootWaitLimit: a program which
+** never gets ready holds neither the batch nor the parent of a daemon forever
+*/
+void Supervisor::waitForBoot()
+{
+    std::unique_lock<std::mutex> lock(mStateMutex);
+    bool is_booted = mStateCondition.wait_for(lock, BootWaitLimit,
+        [this] { return mBootReport.duration >= 0.0 || mIsExiting; });
+
+    if (!is_booted)
+    {
+        lock.unlock();
+        Utils::LogStatus(mLogFile, "Still booting after " + std::to_string(BootWaitLimit.count()) + "s, going on\n");
+    }
+}
+
+/*
+** 1 once every process of the program is READY, or exited with an expected
+** code (a one-shot setup program), -1 if one of them is FATAL or if the
+** program was removed, 0 meanwhile. called with mCommandMutex held.
+*/
+int Supervisor::programReadiness(const string & program)
+{
+    int ready = 1;
+    auto group_it = mGroupMap.find(program);
+
+    if (group_it == mGroupMap.end())
+    {
+        return -1;
+    }
+    for (auto & process : group_it->second.instances)
+    {
+        ProcessState state = process->getState();
+        if (state == ProcessState::Fatal)
+        {
+            return -1;
+        }
+        bool is_up = state == ProcessState::Ready;
+        bool is_done = state == ProcessState::Exited && process->isExpectedReturnValue(process->getReturnValue());
+        if (!is_up && !is_done)
+        {
+            ready = 0;
+        }
+    }
+    return ready;
+}
+
+/*
+** every target is stopped (concurrently, see stopProcesses) before any is started again
+*/
+int Supervisor::restartProcesses(ProcessList & processes)
+{
+    IGNORE(stopProcesses(processes))
+    return startProcesses(processes);
+}
+
+/*
+** rolling-restart <group> [--batch N] [--max-unavailable M] [--timeout S]
+** replace the running replicas of a group N at a time (default 1), with at
+** most M of them (default N) down or not READY at once, see rollOut. the
+** timeout a replica has to be READY defaults to 4 times the slowest readiness
+** seen in the group, 10s at least. runs in the background. warm spares are
+** restarted once every replica was.
+*/
+int Supervisor::rollingRestart(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    RollingRestart plan;
+    string name(mCommandParser.getArgs().front());
+    auto group_it = mGroupMap.find(name);
+    char *end = nullptr;
+
+    if (group_it == mGroupMap.end())
+    {
+        out << "rolling-restart: " << name << ": no such program\n";
+        return 1;
+    }
+    string batch(mCommandParser.getOption("--batch", "1"));
+    string max_unavailable(mCommandParser.getOption("--max-unavailable", batch));
+    string timeout(mCommandParser.getOption("--timeout", "0"));
+    long n = std::strtol(batch.c_str(), &end, 10);
+    plan.batch = (*end == '\0' && n > 0) ? n : 0;
+    n = std::strtol(max_unavailable.c_str(), &end, 10);
+    plan.maxUnavailable = (*end == '\0' && n > 0) ? n : 0;
+    plan.timeout = std::strtod(timeout.c_str(), &end);
+    if (plan.batch == 0 || plan.maxUnavailable < plan.batch || *end != '\0' || plan.timeout < 0.0)
+    {
+        out << "rolling-restart: --batch and --max-unavailable are counts, with "
+               "--max-unavailable at least --batch, --timeout is in seconds\n";
+        return 1;
+    }
+
+    plan.group = name;
+    double slowest = 0.0;
+    for (auto & process : group_it->second.instances)
+    {
+        if (process->isAlive())
+        {
+            plan.processes.push_back(process);
+        }
+        slowest = std::max(slowest, process->getReadyLatency());
+    }
+    if (plan.timeout == 0.0)
+    {
+        plan.timeout = std::max(10.0, 4 * slowest);
+    }
+    plan.spares = group_it->second.spares;
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        if (!mRollingGroups.insert(name).second)
+        {
+            out << "rolling-restart: " << name << ": already in progress\n";
+            return 1;
+        }
+    }
+    out << "rolling-restart: " << name << ": " << plan.processes.size() << " replica(s), "
+        << plan.batch << " at a time, at most " << plan.maxUnavailable << " unavailable\n";
+    detach([this, plan] { rollOut(plan); });
+    return 0;
+}
+
+/*
+** a batch is restarted once there is room for it: the restarted replicas
+** which are not READY yet, and the others which are not READY either, stay
+** under maxUnavailable. with maxUnavailable == batch, batches go one after
+** the other. the first restarted replica to fail (FATAL, BACKOFF, an
+** unexpected exit, or not READY in time) stops the rollout: the replicas
+** left keep running the old version.
+*/
+void Supervisor::rollOut(const RollingRestart & plan)
+{
+    typedef std::chrono::steady_clock Clock;
+    typedef std::pair<std::shared_ptr<Process>, Clock::time_point> Pending;
+    auto timeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(plan.timeout));
+    auto begin = Clock::now();
+    std::vector<Pending> pending;
+    size_t next = 0;
+    size_t n_replaced = 0;
+    string failure;
+    auto seconds = [] (double s) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3) << s << "s";
+        return out.str();
+    };
+
+    while (failure.empty() && (next < plan.processes.size() || !pending.empty()))
+    {
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            version = mStateVersion;
+        }
+        if (mIsExiting)
+        {
+            failure = "taskmaster is exiting";
+            break;
+        }
+        for (auto it = pending.begin(); it != pending.end() && failure.empty();)
+        {
+            const Process & process = *it->first;
+            ProcessState state = process.getState();
+            bool is_failed = state == ProcessState::Fatal || state == ProcessState::Backoff ||
+                (state == ProcessState::Exited && !process.isExpectedReturnValue(process.getReturnValue()));
+            if (is_failed)
+            {
+                failure = process.getProcessName() + " is " + ProcessStateName(state);
+            }
+            else if (state == ProcessState::Ready || state == ProcessState::Exited)
+            {
+                ++n_replaced;
+                it = pending.erase(it);
+                continue;
+            }
+            else if (Clock::now() >= it->second + timeout)
+            {
+                failure = process.getProcessName() + " not READY after " + seconds(plan.timeout);
+            }
+            ++it;
+        }
+        if (!failure.empty())
+        {
+            break;
+        }
+
+        size_t unavailable = pending.size();
+        for (size_t i = 0; i < plan.processes.size(); ++i)
+        {
+            bool is_pending = std::any_of(pending.begin(), pending.end(),
+                [&](const Pending & p) { return p.first == plan.processes[i]; });
+            unavailable += !is_pending && plan.processes[i]->getState() != ProcessState::Ready;
+        }
+        size_t batch = std::min(plan.batch, plan.processes.size() - next);
+        if (batch > 0 && unavailable + batch <= plan.maxUnavailable)
+        {
+            ProcessList replaced(plan.processes.begin() + next, plan.processes.begin() + next + batch);
+            std::vector<StopResult> results;
+            std::vector<string> names;
+            stopAll(replaced, results);
+            for (auto & process : replaced)
+            {
+                startProcess(process);
+                pending.push_back({process, Clock::now()});
+                names.push_back(process->getProcessName());
+            }
+            next += batch;
+            Utils::LogStatus(mLogFile, "rolling-restart " + plan.group + ": " + Utils::JoinStrings(names, ", ") +
+                " (" + std::to_string(next) + "/" + std::to_string(plan.processes.size()) + ")\n");
+            continue;
+        }
+        if (batch > 0 && pending.empty() && Clock::now() >= begin + timeout)
+        {
+            failure = std::to_string(unavailable) + " replica(s) not READY, no room for a batch";
+            break;
+        }
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateCondition.wait_for(lock, 100ms, [this, version] { return mStateVersion != version; });
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    string summary = "rolling-restart " + plan.group + ": " + ((failure.empty()) ?
+        "done, " + std::to_string(n_replaced) + " replica(s) in " + seconds(elapsed) :
+        "aborted, " + failure + ", " + std::to_string(n_replaced) + "/" +
+            std::to_string(plan.processes.size()) + " replaced");
+    if (failure.empty())
+    {
+        Utils::LogSuccess(mLogFile, plan.group, summary);
+        // the spares which were not promoted meanwhile
+        ProcessList spares;
+        std::vector<StopResult> results;
+        std::copy_if(plan.spares.begin(), plan.spares.end(), std::back_inserter(spares),
+            [](const std::shared_ptr<Process> & p) { return p->isSpare() && p->isAlive(); });
+        stopAll(spares, results);
+        for (auto & spare : spares)
+        {
+            startProcess(spare);
+        }
+    }
+    else
+    {
+        Utils::LogError(mLogFile, plan.group, summary);
+    }
+    emitEvent("rolling", nullptr, summary);
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    mRollingGroups.erase(plan.group);
+}
+
+
+/*
+** start and/or restart processes
+*/
+void Supervisor::_start(std::shared_ptr<Process> process, uint64_t run)
+{
+    // a reload which changes the restart policy restarts the process
+    const auto spec = process->getSpec();
+    int number_of_restarts = (spec->shouldRestart != 0) ?
+        spec->numberOfRestarts :
+        1;
+
+    // restart n times if 
+    auto i = 0;
+    while (i < number_of_restarts)
+    {
+        // stopped or started again since: this run is over
+        if (process->getRun() != run)
+        {
+            return ;
+        }
+        setState(process, ProcessState::Starting);
+        auto spawn_begin = std::chrono::steady_clock::now();
+        if (!process->startRun(run))
+        {
+            // unless a run started since did start it
+            if (!process->isAlive())
+            {
+                setState(process, ProcessState::Stopped);
+            }
+            return ;
+        }
+        if (!process->isAlive())
+        {
+            mMetrics.spawnFailures->inc();
+            Utils::LogError(
+                mLogFile,
+                process->getProcessName(),
+                "Did not start. strerror: " + process->getStrerror());
+        }
+        else
+        {
+            mMetrics.spawns->inc();
+            mMetrics.spawnLatency->observe(
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - spawn_begin).count());
+            setState(process, ProcessState::Running);
+            _awaitReady(process, run);
+            if (process->isSpare() && process->getState() == ProcessState::Ready && process->hold(run))
+            {
+                setState(process, ProcessState::Spare);
+            }
+        }
+
+        // the process managed to start, monitor it until it ends
+        int ret = _monitor(process);
+        recordRun(*process);
+        if (process->getRun() != run)
+        {
+            // stopped on purpose, the state is up to whoever stopped it
+            return ;
+        }
+        // a replica which would be restarted is replaced by a spare instead
+        bool is_restarted = spec->shouldRestart == ShouldRestart::Always ||
+            (spec->shouldRestart == ShouldRestart::UnexpectedExit && ret != 0);
+        if (is_restarted && promoteSpare(process, run))
+        {
+            return ;
+        }
+        setState(process, ProcessState::Exited);
+        switch (spec->shouldRestart)
+        {
+        case ShouldRestart::Never:
+            if (ret != 0)
+            {
+                setState(process, ProcessState::Fatal);
+            }
+            return ;
+        case ShouldRestart::Always:
+            break;
+        case ShouldRestart::UnexpectedExit:
+            if (ret != 0)
+            {
+                // restart if there was an error
+                ++i;
+                break;
+            }
+            return ;
+        default:
+            Utils::LogError(
+                mLogFile,
+                process->getProcessName(),
+                "Invalid should_restart value provided. Exiting.");
+            return ;
+        }
+        if (i < number_of_restarts)
+        {
+            process->setRestarts(process->getRestarts() + 1);
+            mMetrics.restarts->inc();
+            mMetrics.backoffs->inc();
+            setState(process, ProcessState::Backoff);
+        }
+    }
+    // out of restarts
+    setState(process, ProcessState::Fatal);
+    return ;
+}
+
+/*
+** put a held spare of the group in the place of a replica which just died:
+** the spare is continued and takes the name of the replica, the replica
+** takes the name of the spare and is started again in the background, as
+** the group's new spare. false if the replica is itself a spare, or if no
+** spare is held.
+*/
+bool Supervisor::promoteSpare(std::shared_ptr<Process> & process, uint64_t run)
+{
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    // stopped while waiting for the lock
+    if (mIsExiting || process->getRun() != run)
+    {
+        return false;
+    }
+    auto group_it = mGroupMap.find(process->getSpec()->name);
+    if (group_it == mGroupMap.end())
+    {
+        return false;
+    }
+    ProcessGroup & group = group_it->second;
+    auto replica = std::find(group.instances.begin(), group.instances.end(), process);
+    auto spare = std::find_if(group.spares.begin(), group.spares.end(),
+        [](const std::shared_ptr<Process> & p) { return p->getState() == ProcessState::Spare; });
+    if (replica == group.instances.end() || spare == group.spares.end())
+    {
+        return false;
+    }
+
+    std::shared_ptr<Process> promoted = *spare;
+    string name = process->getProcessName();
+    string spare_name = promoted->getProcessName();
+    int slot = process->getStatusSlot();
+    promoted->setIsSpare(false);
+    promoted->resume();
+    promoted->setProcessName(name);
+    promoted->setRestarts(process->getRestarts() + 1);
+    process->setIsSpare(true);
+    process->setProcessName(spare_name);
+    process->setRestarts(0);
+    process->setStatusSlot(promoted->getStatusSlot());
+    promoted->setStatusSlot(slot);
+    *replica = promoted;
+    *spare = process;
+    mProcessMap[name] = promoted;
+    mProcessMap[spare_name] = process;
+    mMetrics.promotions->inc();
+    mMetrics.restarts->inc();
+
+    double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - process->getExitTime()).count();
+    Utils::LogStatus(mLogFile, name + ": replaced by spare " + spare_name + " (pid " +
+        std::to_string(promoted->getPid()) + ") " + std::to_string((long)(latency * 1e6)) + "us after its exit\n");
+    emitEvent("promote", promoted.get(), "promoted " + spare_name);
+    setState(promoted, ProcessState::Ready);
+    setState(process, ProcessState::Exited);
+    startProcess(process);
+    return true;
+}
+
+/*
+** RUNNING -> READY, once the program wrote a newline on its ready_fd, or once
+** it ran for start_time without a ready_fd. the exit of the process is watched
+** at the same time through a pidfd (which does not reap it, _monitor does).
+** a program which is not ready within its ready_timeout is stopped, and fails
+** like one which exited unexpectedly.
+*/
+void Supervisor::_awaitReady(std::shared_ptr<Process> & process, uint64_t run)
+{
+    typedef std::chrono::steady_clock Clock;
+    const auto spec = process->getSpec();
+    int ready_pipe = process->getReadyPipe();
+    bool uses_fd = spec->readyFd != -1;
+    long double wait = (uses_fd) ? spec->readyTimeout : spec->startTime;
+    Clock::time_point begin = process->getStartInstant();
+    Clock::time_point deadline = begin + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<long double>(wait));
+    bool has_deadline = !uses_fd || wait > 0.0;
+    int pid_fd = ::syscall(SYS_pidfd_open, process->getPid(), 0);
+    bool is_ready = false;
+
+    while (!is_ready)
+    {
+        struct pollfd fds[2] = {{pid_fd, POLLIN, 0}, {ready_pipe, POLLIN, 0}};
+        int timeout = -1;
+        if (has_deadline)
+        {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout = std::max(0, (int)left.count());
+        }
+        else if (pid_fd == -1 && ready_pipe == -1)
+        {
+            // nothing left to wait on
+            break;
+        }
+        // negative fds are ignored by poll
+        int n = ::poll(fds, 2, timeout);
+        if (n == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n == -1 || (fds[0].revents & POLLIN))
+        {
+            // exited before it was ready
+            break;
+        }
+        if (n == 0 && !uses_fd)
+        {
+            is_ready = true;
+            break;
+        }
+        if (n == 0)
+        {
+            mMetrics.readyTimeouts->inc();
+            Utils::LogError(mLogFile, process->getProcessName(),
+                "not ready after ready_timeout. Stopping it.");
+            process->stop();
+            break;
+        }
+        char buffer[64];
+        ssize_t size = ::read(ready_pipe, buffer, sizeof(buffer));
+        if (size > 0)
+        {
+            is_ready = std::memchr(buffer, '\n', size) != nullptr;
+        }
+        else if (size == 0 || (errno != EINTR && errno != EAGAIN))
+        {
+            // closed without a word: it can still be stopped by ready_timeout
+            process->closeReadyPipe();
+            ready_pipe = -1;
+        }
+    }
+    if (pid_fd != -1)
+    {
+        ::close(pid_fd);
+    }
+    process->closeReadyPipe();
+    if (!is_ready || process->getRun() != run)
+    {
+        return ;
+    }
+    double latency = std::chrono::duration<double>(Clock::now() - begin).count();
+    process->setReadyLatency(latency);
+    mMetrics.readyLatency->observe(latency);
+    setState(process, ProcessState::Ready);
+}
+
+/*
+** every state change goes through here, so that it is published
+*/
+void Supervisor::setState(const std::shared_ptr<Process> & process, ProcessState state)
+{
+    ProcessState previous = process->getState();
+
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        process->setState(state);
+        ++mStateVersion;
+    }
+    mStateCondition.notify_all();
+    mMetrics.processes->add(previous, -1);
+    mMetrics.processes->add(state);
+    publishStatus(*process);
+    emitEvent(ProcessStateName(state), process.get(),
+        string("state ") + ProcessStateName(previous) + " " + ProcessStateName(state));
+}
+
+void Supervisor::publishStatus(const Process & process)
+{
+    StatusTable::EntryData data = {};
+
+    if (process.getStatusSlot() == -1)
+    {
+        return ;
+    }
+    const struct rusage & usage = process.getUsage();
+    data.inUse = 1;
+    data.state = process.getState();
+    data.pid = process.getPid();
+    data.lastExitCode = process.getReturnValue();
+    data.restarts = process.getRestarts();
+    data.lastSignal = process.getLastSignal();
+    data.startTime = process.getExecTime();
+    data.exitTime = process.getExitWallTime();
+    data.userTimeUs = usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+    data.systemTimeUs = usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+    data.maxRssKb = usage.ru_maxrss;
+    std::strncpy(data.name, process.getProcessName().c_str(), StatusTable::NameSize - 1);
+    mStatusTable.write(process.getStatusSlot(), data);
+}
+
+[[nodiscard]]
+int Supervisor::_monitor(std::shared_ptr<Process>& process)
+{
+    int ret = 0;
+    bool has_error = false;
+    struct rusage usage = {};
+    const auto spec = process->getSpec();
+
+    ::wait4(process->getPid(), &ret, 0, &usage);
+    process->setUsage(usage);
+    process->setExitWallTime(std::time(nullptr));
+    // how it ended is set before it is seen dead, see stopAll
+    process->setLastSignal((WIFSIGNALED(ret)) ? WTERMSIG(ret) : 0);
+    process->setReturnValue((WIFEXITED(ret)) ? WEXITSTATUS(ret) : -1);
+    process->setIsAlive(false);
+    if (WIFEXITED(ret))
+    {
+        mMetrics.exitCodes->add(WEXITSTATUS(ret));
+        emitEvent("exit", process.get(), "exit code " + std::to_string(WEXITSTATUS(ret)));
+    }
+    else if (WIFSIGNALED(ret))
+    {
+        mMetrics.exitSignals->add(WTERMSIG(ret));
+        emitEvent("exit", process.get(), "exit signal " + std::to_string(WTERMSIG(ret)));
+        Utils::LogStatus(
+            mLogFile,
+            "Process " + process->getProcessName() +
+            " killed by signal: " + std::to_string(WTERMSIG(ret)) + "\n");
+    }
+
+    // if a start_time was set in config, we need to make sure that we did not return 
+    //  too early by doing current ?> exec_time + start_time
+    if (spec->startTime != 0.0 &&
+        std::time(nullptr) < (process->getExecTime() + spec->startTime))
+    {
+        Utils::LogError(
+            mLogFile,
+            process->getProcessName(),
+            "Returned too early.");
+        has_error = true;
+    }
+    if (!process->isExpectedReturnValue(process->getReturnValue()))
+    {
+        Utils::LogError(
+            mLogFile,
+            process->getProcessName(),
+            "Unexpected return value: " + std::to_string(process->getReturnValue()) +
+            " expected: " + std::to_string(spec->expectedReturnValues.front()));
+        has_error = true;
+    }
+    if (!has_error)
+    {
+        Utils::LogSuccess(
+            mLogFile,
+            process->getProcessName(),
+            "Terminated without errors.");
+    }
+    else 
+    {
+        Utils::LogError(
+            mLogFile,
+            process->getProcessName(),
+            "Encountered problems.");
+    }
+    return has_error;
+}
+
+/*
+** resize the group of a program with an autoscale_metric, see Autoscaler.
+** on a thread of its own, started by onAutoscaleTimer: the metric is sampled
+** without the command lock, a slow autoscale_command holds back neither the
+** commands nor the other programs. a program which is not running, or is
+** being rolled out, is left alone.
+*/
+void Supervisor::_autoscale(std::shared_ptr<const ProgramSpec> spec)
+{
+    const string & name = spec->name;
+    std::vector<int> pids;
+    int current;
+    int replicas;
+    double value;
+    string error;
+
+    {
+        std::lock_guard<std::mutex> lock(mCommandMutex);
+        auto group_it = mGroupMap.find(name);
+        if (mIsExiting || group_it == mGroupMap.end() || group_it->second.spec != spec)
+        {
+            return ;
+        }
+        current = group_it->second.replicas;
+        for (auto & process : group_it->second.instances)
+        {
+            if (process->isAlive())
+            {
+                pids.push_back(process->getPid());
+            }
+        }
+    }
+    if (pids.empty())
+    {
+        return ;
+    }
+    int ret = mAutoscaler.sample(*spec, pids, current, replicas, value, error);
+    if (ret == -1)
+    {
+        Utils::LogError(mLogFile, name, error);
+    }
+    if (ret != 1 || replicas == current)
+    {
+        return ;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        if (mRollingGroups.count(name))
+        {
+            return ;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    auto group_it = mGroupMap.find(name);
+    // reloaded or resized meanwhile: sampled again next time
+    if (mIsExiting || group_it == mGroupMap.end() || group_it->second.spec != spec ||
+        group_it->second.replicas != current)
+    {
+        return ;
+    }
+    std::ostringstream details;
+    details << "autoscale " << current << " -> " << replicas << " replica(s) ("
+            << spec->autoscaleMetric << " " << value << ", target "
+            << spec->autoscaleTarget << " per replica)";
+    Utils::LogStatus(mLogFile, name + ": " + details.str() + "\n");
+    emitEvent("scale", nullptr, name + " " + details.str());
+    mMetrics.autoscales->inc();
+    group_it->second.replicas = replicas;
+    scaleGroup(group_it->second);
+}
+
+[[nodiscard]]
+int Supervisor::stopProcess(std::shared_ptr<Process> & process)
+{
+    ProcessList processes = {process};
+
+    return stopProcesses(processes);
+}
+
+[[nodiscard]]
+int Supervisor::stopProcesses(ProcessList & processes)
+{
+    ProcessList stopping;
+    std::vector<StopResult> results;
+
+    for (auto & process : processes)
+    {
+        // ended first: a start in progress either is cancelled, or is done
+        //  and finds the process alive
+        process->endRun();
+        if (!process->isAlive())
+        {
+            Utils::LogError(mLogFile, process->getProcessName(), "is not running.");
+            continue;
+        }
+        stopping.push_back(process);
+    }
+    stopAll(stopping, results);
+    return 0;
+}
+
+/*
+** send every kill signal first, then wait for the processes against a single
+** deadline, the longest grace period (force_quit_wait_time) of the batch:
+** stopping n processes takes about as long as the slowest of them. only
+** the processes still alive once it expired are killed with SIGKILL.
+*/
+void Supervisor::stopAll(const ProcessList & processes, std::vector<StopResult> & results)
+{
+    auto begin = std::chrono::steady_clock::now();
+    double grace = 0.0;
+
+    for (auto & process : processes)
+    {
+        // don't let the monitor restart it
+        process->endRun();
+        setState(process, ProcessState::Stopping);
+        if (process->stop() == 1)
+        {
+            Utils::LogError(mLogFile, process->getProcessName(),
+                "kill(" + std::to_string(process->getKillSignal()) + ") failed: " + std::strerror(errno));
+        }
+        grace = std::max(grace, process->getForceQuitWaitTime());
+    }
+    auto deadline = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(grace));
+    for (auto & process : processes)
+    {
+        // past the deadline, this only tells whether it is still alive
+        if (!process->waitForExit(deadline))
+        {
+            Utils::LogError(mLogFile, process->getProcessName(),
+                "still running after force_quit_wait_time. Force quitting (using SIGKILL).");
+            process->kill();
+            process->waitForExit();
+        }
+        // it may have exited on its own in between
+        bool killed = process->getLastSignal() == SIGKILL;
+        if (!killed)
+        {
+            Utils::LogSuccess(mLogFile, process->getProcessName(), "Terminated.");
+        }
+        setState(process, ProcessState::Stopped);
+        results.push_back({process,
+            std::chrono::duration<double>(process->getExitTime() - begin).count(), killed});
+        mMetrics.stopLatency->observe(results.back().latency);
+    }
+}
+
+/*
+** graceful shutdown of everything that runs, reporting how long each program
+** took to stop (its slowest process). returns the number of stopped processes.
+*/
+int Supervisor::stopAllProcesses(std::ostream & out)
+{
+    typedef struct ProgramStop {
+        size_t processes = 0;
+        size_t killed = 0;
+        double latency = 0.0;
+    } ProgramStop;
+    // highest dependency level first: dependents stop before what they depend on
+    std::map<int, ProcessList, std::greater<int> > levels;
+    std::vector<StopResult> results;
+    std::map<string, ProgramStop> programs;
+
+    for (auto & [name, group] : mGroupMap)
+    {
+        for (auto & process : GroupProcesses(group))
+        {
+            // stopped first, so the monitor can't start it again in between
+            process->endRun();
+            if (process->isAlive())
+            {
+                levels[mDependencyGraph.getLevel(name)].push_back(process);
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mPoolMutex);
+        for (auto & [name, pool] : mPools)
+        {
+            pool.queue.clear();
+            for (auto & job : pool.running)
+            {
+                job.process->endRun();
+                if (job.process->isAlive())
+                {
+                    levels[mDependencyGraph.getLevel(name)].push_back(job.process);
+                }
+            }
+        }
+    }
+    if (levels.empty())
+    {
+        return 0;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    for (auto & [level, processes] : levels)
+    {
+        stopAll(processes, results);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    for (auto & result : results)
+    {
+        ProgramStop & program = programs[result.process->getSpec()->name];
+        program.processes += 1;
+        program.killed += result.killed;
+        program.latency = std::max(program.latency, result.latency);
+    }
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "==== taskmaster shutdown ====\n";
+    for (auto & [name, program] : programs)
+    {
+        report << name << ": " << program.processes << " process(es) stopped in "
+               << program.latency << "s";
+        if (program.killed)
+        {
+            report << ", " << program.killed << " killed (SIGKILL)";
+        }
+        report << "\n";
+    }
+    report << "stopped " << results.size() << " process(es) in " << elapsed << "s\n";
+    out << report.str();
+    Utils::LogStatus(mLogFile, report.str());
+    return results.size();
+}
+
+/*
+** filtered on this side (see StatusQuery.hpp), rows are written out in
+** chunks of StatusChunkSize from a buffer kept between calls
+*/
+int Supervisor::getProcessStatus(ProcessList & processes, std::ostream & out)
+{
+    const size_t StatusChunkSize = 64 * 1024;
+    bool is_json = mCommandParser.hasOption("--json");
+    bool is_tsv = mCommandParser.hasOption("--tsv");
+    std::string_view fields = mCommandParser.getOption("--fields");
+    time_t now = std::time(nullptr);
+    string error;
+
+    if (is_json && is_tsv)
+    {
+        out << "status: --json and --tsv are exclusive\n";
+        return 1;
+    }
+    StatusQuery::Format format = (is_json) ? StatusQuery::Json : (is_tsv) ? StatusQuery::Tsv : StatusQuery::Text;
+    if (mStatusQuery.parse(format, fields, mCommandParser.getOption("--where"), error) != 0)
+    {
+        out << error << "\n";
+        return 1;
+    }
+    // the full description, unless fields or a format are asked for
+    bool is_described = format == StatusQuery::Text && fields.empty();
+
+    mStatusBuffer.clear();
+    mStatusQuery.writeHeader(mStatusBuffer);
+    for (auto & process : processes)
+    {
+        if (!mStatusQuery.matches(*process, now))
+        {
+            continue;
+        }
+        if (is_described)
+        {
+            out << *process.get() << "\n";
+            continue;
+        }
+        mStatusQuery.writeRow(*process, now, mStatusBuffer);
+        if (mStatusBuffer.size() >= StatusChunkSize)
+        {
+            out.write(mStatusBuffer.data(), mStatusBuffer.size());
+            mStatusBuffer.clear();
+        }
+    }
+    out.write(mStatusBuffer.data(), mStatusBuffer.size());
+    return 0;
+}
+
+/*
+** runs <program>: when it runs next if it is scheduled, and the last exits of
+** its processes
+*/
+int Supervisor::runs(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    string name(mCommandParser.getArgs().front());
+    std::ostringstream report;
+
+    if (mGroupMap.find(name) == mGroupMap.end())
+    {
+        out << "runs: " << name << ": no such program\n";
+        return 1;
+    }
+    report << std::fixed << std::setprecision(3);
+    report << "==== " << name << " runs ====\n";
+    {
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        auto job = mJobs.find(name);
+        if (job != mJobs.end())
+        {
+            report << "schedule: " << job->second.spec->schedule << ", next run "
+                   << ((job->second.due < 0.0) ? "never" : FormatTime(job->second.due))
+                   << ((job->second.isQueued) ? ", one queued" : "") << "\n";
+        }
+    }
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    for (auto & run : mRunHistory[name])
+    {
+        report << FormatTime(run.startTime) << " " << run.process << " " << run.duration << "s "
+               << ((run.signal) ? "signal " + std::to_string(run.signal) : "exit " + std::to_string(run.exitCode))
+               << "\n";
+    }
+    out << report.str();
+    return 0;
+}
+
+/*
+** push-metric <program> <value>: the metric of a program with autoscale_metric
+** push, used from its next sample on
+*/
+int Supervisor::pushMetric(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    string name(mCommandParser.getArgs()[0]);
+    string value(mCommandParser.getArgs()[1]);
+    auto group_it = mGroupMap.find(name);
+    char *end = nullptr;
+
+    if (group_it == mGroupMap.end() || group_it->second.spec->autoscaleMetric != "push")
+    {
+        out << "push-metric: " << name << ": no such program with autoscale_metric push\n";
+        return 1;
+    }
+    double number = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || !std::isfinite(number) || number < 0.0)
+    {
+        out << "push-metric: " << value << ": not a positive number\n";
+        return 1;
+    }
+    mAutoscaler.push(name, number);
+    return 0;
+}
+
+/*
+** submit <pool> [--env KEY=VALUE]... [-- args...]: queue a job, started as
+** soon as the pool has a free slot. rejected once job_queue_size jobs wait.
+*/
+int Supervisor::submit(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    const std::vector<std::string_view> & args = mCommandParser.getArgs();
+    string name(args.front());
+    auto group_it = mGroupMap.find(name);
+    PoolJob job = {};
+
+    if (group_it == mGroupMap.end() || group_it->second.spec->jobPoolSize == 0)
+    {
+        out << "submit: " << name << ": no such program with job_pool_size\n";
+        return 1;
+    }
+    for (auto & variable : mCommandParser.getOptions("--env"))
+    {
+        size_t equal = variable.find('=');
+        if (equal == std::string_view::npos || equal == 0)
+        {
+            out << "submit: --env " << variable << ": expected KEY=VALUE\n";
+            return 1;
+        }
+        job.environment.emplace_back(variable.substr(0, equal), variable.substr(equal + 1));
+    }
+    job.arguments.assign(args.begin() + 1, args.end());
+    job.submitTime = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    JobPool & pool = mPools[name];
+    if ((int)pool.queue.size() >= pool.spec->jobQueueSize)
+    {
+        mMetrics.jobsRejected->inc();
+        out << "submit: " << name << ": queue full (" << pool.queue.size() << " jobs waiting)\n";
+        return 1;
+    }
+    job.id = mNextJobId++;
+    mMetrics.jobsSubmitted->inc();
+    out << "job " << job.id << " submitted\n";
+    pool.queue.push_back(std::move(job));
+    dispatchJobs(pool);
+    return 0;
+}
+
+/*
+** jobs <pool>: the last finished jobs, then the running and queued ones
+*/
+int Supervisor::jobs(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    string name(mCommandParser.getArgs().front());
+    auto now = std::chrono::steady_clock::now();
+    std::ostringstream report;
+
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    auto pool_it = mPools.find(name);
+    if (pool_it == mPools.end())
+    {
+        out << "jobs: " << name << ": no such job pool\n";
+        return 1;
+    }
+    const JobPool & pool = pool_it->second;
+    report << std::fixed << std::setprecision(3);
+    report << "==== " << name << " jobs ====\n";
+    report << pool.running.size() << "/" << pool.spec->jobPoolSize << " running, "
+           << pool.queue.size() << "/" << pool.spec->jobQueueSize << " queued\n";
+    for (auto & job : pool.finished)
+    {
+        const Process & process = *job.process;
+        report << "job " << job.id << " " << process.getProcessName() << " "
+               << ((process.getLastSignal()) ?
+                   "signal " + std::to_string(process.getLastSignal()) :
+                   "exit " + std::to_string(process.getReturnValue()))
+               << " after " << std::chrono::duration<double>(process.getExitTime() - process.getStartInstant()).count()
+               << "s, waited " << job.wait << "s\n";
+    }
+    for (auto & job : pool.running)
+    {
+        const Process & process = *job.process;
+        report << "job " << job.id << " " << process.getProcessName() << " running, pid " << process.getPid()
+               << ", for " << std::chrono::duration<double>(now - process.getStartInstant()).count()
+               << "s, waited " << job.wait << "s\n";
+    }
+    for (auto & job : pool.queue)
+    {
+        report << "job " << job.id << " queued for "
+               << std::chrono::duration<double>(now - job.submitTime).count() << "s\n";
+    }
+    out << report.str();
+    return 0;
+}
+
+/*
+** boot-report: the startup timeline, one priority class after the other,
+** in seconds since the boot began
+*/
+int Supervisor::bootReport(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    std::ostringstream report;
+    BootReport boot;
+
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        boot = mBootReport;
+    }
+    report << std::fixed << std::setprecision(3);
+    report << "==== taskmaster boot ====\n";
+    size_t next = 0;
+    for (size_t i = 0; i < boot.classes.size(); ++i)
+    {
+        const BootClass & boot_class = boot.classes[i];
+        report << "priority " << boot_class.priority << ": ";
+        if (boot_class.opened < 0.0)
+        {
+            report << "waiting";
+        }
+        else
+        {
+            report << "started at " << boot_class.opened << "s";
+        }
+        report << ", window " << boot_class.window << "s";
+        if (boot_class.closed >= 0.0)
+        {
+            report << ", done at " << boot_class.closed << "s (" << boot_class.reason << ")";
+        }
+        report << "\n";
+        for (; next < boot.programs.size() && boot.programs[next].priority == boot_class.priority; ++next)
+        {
+            const BootProgram & program = boot.programs[next];
+            report << "  " << program.name << ": ";
+            if (program.launched >= 0.0)
+            {
+                report << "launched at " << program.launched << "s";
+            }
+            else if (boot_class.opened >= 0.0 && program.status == 0)
+            {
+                report << "due at " << boot_class.opened + program.offset << "s";
+            }
+            else
+            {
+                report << "not launched";
+            }
+            if (program.status != 0)
+            {
+                report << ", " << ((program.status == 1) ? "ready" : "failed") << " at " << program.done << "s";
+            }
+            report << ((program.note.empty()) ? "" : ", " + program.note) << "\n";
+        }
+    }
+    if (boot.duration >= 0.0)
+    {
+        report << "booted " << boot.programs.size() << " program(s) in " << boot.duration << "s\n";
+    }
+    else
+    {
+        report << "booting\n";
+    }
+    out << report.str();
+    return 0;
+}
+
+int Supervisor::printHelp(ProcessList & processes, std::ostream & stream)
+{
+    IGNORE(processes);
+    string out;
+    out += "=========Taskmaster========\n";
+    out += "----available commands:----\n";
+    out += "help          : Print this help\n";
+    out += "reload        : reload config (" + configDescription() + ")\n";
+    out += "start   <targets> : start processes\n";
+    out += "stop    <targets> : stop processes, waiting force_quit_wait_time before SIGKILL\n";
+    out += "restart <targets> : stop then start processes\n";
+    out += "rolling-restart <program> [--batch N] [--max-unavailable M] [--timeout S]\n";
+    out += "  restart running replicas N at a time once READY, stop at the first failure\n";
+    out += "status [targets]  : get status of processes (default: all)\n";
+    out += "  [--json|--tsv] [--fields name,state,pid,uptime...] [--where state=FATAL,name=web_*...]\n";
+    out += "  fields: name group state pid uptime restarts exit_code signal start_time\n";
+    out += "          exit_time user_time system_time max_rss ready_latency. conditions: = != < >\n";
+    out += "  targets are process names, program names (all of their processes),\n";
+    out += "  globs (eg: web_*) or all. they are stopped concurrently.\n";
+    out += "list [prefix] : list configured processes, in order\n";
+    out += "push-metric <program> <value> : feed the autoscaler of a program (autoscale_metric: push)\n";
+    out += "runs <program> : its schedule and the last exits of its processes, with how long they ran\n";
+    out += "submit <pool> [--env KEY=VALUE]... [-- args...] : queue a job, start_command with args appended\n";
+    out += "jobs <pool>   : the jobs of a pool, finished, running and queued\n";
+    out += "boot-report   : when each program started at boot and was ready, by priority class\n";
+    out += "subscribe [targets] [--events kinds] : stream state changes, exits and reloads\n";
+    out += "  (control socket only, see taskmasterctl)\n";
+    out += "validate      : check every loaded program (paths, signals, ranges)\n";
+    out += "history       : command history\n";
+    out += "exit          : terminate all programs and exit\n";
+    stream << out;
+    return 0;
+}
+
+/*
+** reload process configuration, or, if no process is specified,
+**  reload full config
+*/
+int Supervisor::reloadConfig(ProcessList & processes)
+{
+    IGNORE(processes);
+    auto begin = std::chrono::steady_clock::now();
+    int ret = loadConfig(true);
+    mMetrics.reloadDuration->observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    emitEvent("reload", nullptr, (ret == 0) ?
+        "reload ok " + std::to_string(getConfigErrors().size()) + " error(s)" :
+        "reload failed");
+    return ret;
+}
+
+int Supervisor::exit(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    mIsExiting = true;
+
+    std::cout.flush();
+    stopAllProcesses(out);
+    return 0;
+}
+
+/*
+** run the pre-flight checks on every loaded program, along with the errors
+** found while loading the config. returns the number of issues.
+*/
+int Supervisor::checkConfig(std::ostream & out)
+{
+    std::vector<std::shared_ptr<const ProgramSpec> > specs;
+
+    specs.reserve(mGroupMap.size());
+    for (auto & [name, group] : mGroupMap)
+    {
+        specs.push_back(group.spec);
+    }
+    auto issues = Validator::ValidatePrograms(specs);
+    auto errors = getConfigErrors();
+    issues.insert(issues.begin(), errors.begin(), errors.end());
+    return Validator::Report(out, issues, specs.size());
+}
+
+int Supervisor::validate(ProcessList & processes, std::ostream & out)
+{
+    IGNORE(processes);
+    return checkConfig(out);
+}
+
+int Supervisor::history(ProcessList & processes, std::ostream & stream)
+{
+    IGNORE(processes);
+    string out =
+        "==== taskmaster command history ====\n";
+
+    HIST_ENTRY** history_entry_list = history_list();
+    if (history_entry_list)
+    {
+        for (int i = 0; history_entry_list[i] != nullptr; i++)
         {
             out += string(history_entry_list[i]->line) + "\n";
         }
     }
-    std::cout << out;
+    stream << out;
+    return 0;
+}
+
+/*
+** list [prefix]: process names in order
+*/
+int Supervisor::listProcesses(ProcessList & processes, std::ostream & stream)
+{
+    IGNORE(processes);
+    std::vector<string> names;
+    string out =
+        "==== taskmaster configured programs list ====\n";
+
+    mNameIndex.find(mCommandParser.getArgs().empty() ? "" : mCommandParser.getArgs().front(), names);
+    for (auto & name : names)
+    {
+        // a program without replicas only has its group name
+        auto process = mProcessMap.find(name);
+        if (process != mProcessMap.end() && process->second)
+        {
+            out += name + "\n";
+        }
+    }
+    stream << out;
+    return 0;
+}
+
+string Supervisor::configDescription() const
+{
+    string out = mConfigLoader.getConfigPath();
+    if (!mConfigLoader.getConfigDir().empty())
+    {
+        out += (out.empty() ? "" : ", ") + mConfigLoader.getConfigDir() + "/";
+    }
+    return out;
+}
+
+/*
+** load configuration from the provided .yaml fragments (see ConfigLoader);
+** some options are mandatory and their absence will raise an error
+**
+** upon reload, override_existing is set to true; only programs from fragments
+** which changed on disk are looked at again. a program whose parameters were
+** changed only has its processes restarted if ProgramSchema::NeedsRestart says
+** so, the others pick the new spec up on their next start. programs which are
+** not defined anymore are stopped and removed, unless their fragment failed to
+** parse: those keep running as they were.
+*/
+int Supervisor::loadConfig(bool override_existing)
+{
+    int ret = mConfigLoader.load(mLogFile);
+
+    // "" holds the errors which are not tied to a fragment, found again on each load
+    mConfigErrors.erase("");
+    for (auto & error : mConfigLoader.getErrors())
+    {
+        mConfigErrors[""].push_back({error.source, error.field, error.message});
+    }
+    if (ret != 0)
+    {
+        // a failed reload keeps the programs which are already loaded
+        if (!override_existing)
+        {
+            mIsConfigValid = false;
+        }
+        return (1);
+    }
+
+    std::erase_if(mConfigErrors, [this, override_existing](const auto & entry) {
+        return !entry.first.empty() && (!override_existing || !mConfigLoader.isUnchanged(entry.first));
+    });
+    for (auto & program : mConfigLoader.getPrograms(override_existing))
+    {
+        ProgramSpec spec;
+        std::vector<ValidationIssue> issues;
+
+        mLoadingFragment = program.fragment->path;
+
+        spec.environment.setBase(mBaseEnvironment);
+        bool is_bound = ProgramSchema::Bind(program.node, spec, issues);
+        for (auto & issue : issues)
+        {
+            configError(issue.program.empty() ? program.fragment->path : issue.program, issue.field, issue.message);
+        }
+        if (!is_bound)
+        {
+            continue;
+        }
+        spec.hash = ProgramSchema::Hash(spec);
+
+        auto old_group_it = mGroupMap.find(spec.name);
+        if (old_group_it != mGroupMap.end() && !override_existing)
+        {configError(spec.name, "name", "already exists in process list."); continue; }
+        if (old_group_it != mGroupMap.end())
+        {
+            old_group_it->second.fragment = program.fragment->path;
+        }
+
+        // compare against the existing spec, some changes restart the program's processes
+        bool restart = false;
+        if (old_group_it != mGroupMap.end())
+        {
+            const ProgramSpec & old_spec = *old_group_it->second.spec;
+            if (old_spec.hash == spec.hash && ProgramSchema::Diff(old_spec, spec).empty())
+            {
+                continue;
+            }
+            restart = ProgramSchema::NeedsRestart(old_spec, spec);
+            if (restart)
+            {
+                Utils::LogStatus(mLogFile, "restarting process " + spec.name + " (" +
+                    Utils::JoinStrings(ProgramSchema::Diff(old_spec, spec), ", ") + " changed)\n");
+            }
+        }
+
+        issues = Validator::ValidateAutoscale(spec);
+        auto pool_issues = Validator::ValidateJobPool(spec);
+        issues.insert(issues.end(), pool_issues.begin(), pool_issues.end());
+        for (auto & issue : issues)
+        {
+            configError(issue.program, issue.field, issue.message);
+        }
+        if (!issues.empty() || bindSockets(spec) != 0)
+        {
+            continue;
+        }
+        bool was_watched = old_group_it != mGroupMap.end() &&
+            (old_group_it->second.spec->lazyStart || old_group_it->second.spec->idleTimeout > 0.0);
+        bool was_autoscaled = old_group_it != mGroupMap.end() && !old_group_it->second.spec->autoscaleMetric.empty();
+        bool was_scheduled = old_group_it != mGroupMap.end() && !old_group_it->second.spec->schedule.empty();
+
+        // replicas all share this spec, each of them only holds its runtime state
+        if (old_group_it == mGroupMap.end())
+        {
+            mNameIndex.insert(spec.name);
+        }
+        ProcessGroup & group = mGroupMap[spec.name];
+        group.spec = std::make_shared<const ProgramSpec>(std::move(spec));
+        group.fragment = program.fragment->path;
+        ProcessList processes = GroupProcesses(group);
+        for (auto & process : processes)
+        {
+            process->setSpec(group.spec);
+        }
+        // a reload keeps the count the autoscaler reached, within the new bounds
+        group.replicas = (was_autoscaled) ? group.replicas : group.spec->numberOfProcesses;
+        if (!group.spec->autoscaleMetric.empty())
+        {
+            group.replicas = std::clamp(group.replicas, group.spec->autoscaleMin, group.spec->autoscaleMax);
+        }
+        // a pool only runs the jobs submitted to it
+        group.replicas = (group.spec->jobPoolSize > 0) ? 0 : group.replicas;
+        scaleGroup(group);
+        updatePool(group.spec);
+
+        if (restart)
+        {
+            processes = GroupProcesses(group);
+            IGNORE(restartProcesses(processes))
+        }
+        if (override_existing && (was_watched || group.spec->lazyStart || group.spec->idleTimeout > 0.0))
+        {
+            armSocketWatch(group.spec);
+        }
+        if (override_existing && (was_autoscaled || !group.spec->autoscaleMetric.empty()))
+        {
+            armAutoscale(group.spec);
+        }
+        if (override_existing && (was_scheduled || !group.spec->schedule.empty()))
+        {
+            armSchedule(group.spec);
+        }
+    }
+    mLoadingFragment.clear();
+    if (override_existing)
+    {
+        std::vector<string> removed;
+        for (auto & [name, group] : mGroupMap)
+        {
+            if (!mConfigLoader.isDefined(name) && !mConfigLoader.isInvalid(group.fragment))
+            {
+                removed.push_back(name);
+            }
+        }
+        for (auto & name : removed)
+        {
+            removeProgram(name);
+        }
+    }
+    buildDependencyGraph();
+    mIsConfigValid = (mProcessMap.size() > 0) || std::any_of(mGroupMap.begin(), mGroupMap.end(),
+        [](const auto & entry) { return entry.second.spec->jobPoolSize > 0; });
+    return (0);
+}
+
+void Supervisor::buildDependencyGraph()
+{
+    std::vector<std::shared_ptr<const ProgramSpec> > specs;
+    std::vector<ValidationIssue> issues;
+
+    specs.reserve(mGroupMap.size());
+    for (auto & [name, group] : mGroupMap)
+    {
+        specs.push_back(group.spec);
+    }
+    mDependencyGraph.build(specs, issues);
+    for (auto & issue : issues)
+    {
+        configError(issue.program, issue.field, issue.message);
+    }
+}
+
+/*
+** listen on the program's sockets, or take them over from the spec it
+** replaces: the processes of both share them. nothing is bound on a dry run.
+*/
+int Supervisor::bindSockets(ProgramSpec & spec)
+{
+    if (mOptions.isDryRun)
+    {
+        return 0;
+    }
+    auto issues = Validator::ValidateSockets(spec);
+    for (auto & issue : issues)
+    {
+        configError(issue.program, issue.field, issue.message);
+    }
+    if (!issues.empty())
+    {
+        return 1;
+    }
+    for (auto & address : spec.sockets)
+    {
+        BoundSocket & bound = mListenSockets[address];
+        std::shared_ptr<ListenSocket> socket = bound.socket.lock();
+        if (socket && bound.program != spec.name)
+        {
+            configError(spec.name, "sockets", address + ": already used by " + bound.program);
+            return 1;
+        }
+        if (!socket && (socket = ListenSocket::Open(address)) == nullptr)
+        {
+            configError(spec.name, "sockets", address + ": " + std::strerror(errno));
+            return 1;
+        }
+        bound = {spec.name, socket};
+        spec.listenSockets.push_back(socket);
+    }
     return 0;
 }
 
-int Supervisor::listProcesses(std::shared_ptr<Process>& process)
+/*
+** (re)start watching the program's sockets, with the sockets of this spec:
+** a lazy_start program waits for a connection to start, one with
+** idle_timeout is stopped once no connection came for that long and waits
+** for the next one. a spec with neither only stops the watch.
+** the sockets are edge-triggered, each new connection is seen once and left
+** in the backlog for the program to accept.
+*/
+void Supervisor::armSocketWatch(const std::shared_ptr<const ProgramSpec> & spec)
 {
-    IGNORE(process);
-    string out =
-        "==== taskmaster configured programs list ====\n";
-    for (auto & v : mProcessMap)
-    {
-        if (v.second.get() != nullptr)
+    mEventLoop.post([this, spec] {
+        auto old = mSocketWatches.find(spec->name);
+        // stopped for being idle, it keeps waiting across a reload
+        bool is_waiting = spec->lazyStart || (old != mSocketWatches.end() && old->second.isWaiting);
+
+        disarmSocketWatch(spec->name);
+        if (!spec->lazyStart && spec->idleTimeout <= 0.0)
+        {
+            return ;
+        }
+        SocketWatch & watch = mSocketWatches[spec->name];
+        watch = {spec, is_waiting, EventLoop::Clock::now(), 0};
+        for (auto & socket : spec->listenSockets)
+        {
+            mEventLoop.addFd(socket->getFd(), EPOLLIN | EPOLLET, [this, name = spec->name] (uint32_t) {
+                onConnection(name);
+            });
+        }
+        if (spec->idleTimeout > 0.0)
         {
-            out += v.second->getProcessName() + "\n";
+            watch.timer = mEventLoop.addTimer(watch.lastConnection + Seconds(spec->idleTimeout),
+                [this, name = spec->name] { onIdleTimer(name); });
         }
+    });
+}
+
+void Supervisor::disarmSocketWatch(const string & program)
+{
+    auto it = mSocketWatches.find(program);
+
+    if (it == mSocketWatches.end())
+    {
+        return ;
     }
-    std::cout << out;
-    return 0;
+    for (auto & socket : it->second.spec->listenSockets)
+    {
+        mEventLoop.removeFd(socket->getFd());
+    }
+    mEventLoop.cancelTimer(it->second.timer);
+    mSocketWatches.erase(it);
 }
 
 /*
-** load configuration from the provided .yaml file;
-** some options are mandatoru and their absence will raise an error
-**
-** upon reload, override_existing is set to true; for processes whose parameters were changed,
-** only a few of them will cause the program to restart them.
-** these are:
-** ['', '']
-*/
-int Supervisor::loadConfig(const string & config_path, bool override_existing)
-{
-    YAML::Node config;
-    try {
-        config = YAML::LoadFile(config_path);
-    } catch (std::exception e) {
-        mIsConfigValid = false;
-        Utils::LogError(mLogFile, config_path, "YAML::BadFile.");
-        return (1);
+** on the loop thread: the connection is left in the backlog, for the
+** program to accept once started
+*/
+void Supervisor::onConnection(const string & program)
+{
+    auto watch = mSocketWatches.find(program);
+
+    if (watch == mSocketWatches.end())
+    {
+        return ;
+    }
+    watch->second.lastConnection = EventLoop::Clock::now();
+    if (!watch->second.isWaiting)
+    {
+        return ;
+    }
+    watch->second.isWaiting = false;
+    if (watch->second.spec->idleTimeout <= 0.0)
+    {
+        // lazy_start only: nothing left to watch
+        disarmSocketWatch(program);
+    }
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    auto it = mGroupMap.find(program);
+    if (it == mGroupMap.end())
+    {
+        return ;
+    }
+    Utils::LogStatus(mLogFile, "Connection for " + program + ", starting it\n");
+    ProcessList processes = GroupProcesses(it->second);
+    IGNORE(startProcesses(processes))
+}
+
+/*
+** on the loop thread, every idle_timeout at most: the program is stopped
+** from another thread if no connection came since the last check.
+** connections are seen as they are queued, which may be missed if the
+** program accepts first: see stopIdle for the ones still open.
+*/
+void Supervisor::onIdleTimer(const string & program)
+{
+    auto it = mSocketWatches.find(program);
+
+    if (it == mSocketWatches.end())
+    {
+        return ;
     }
+    SocketWatch & watch = it->second;
+    auto now = EventLoop::Clock::now();
+    auto idle = Seconds(watch.spec->idleTimeout);
 
-    auto processes_node = config["supervisor-processes"];
-    if (!processes_node)
+    watch.timer = 0;
+    if (now < watch.lastConnection + idle)
     {
-        mIsConfigValid = false;
-        Utils::LogError(mLogFile, config_path, "supervisor-processes node not found.");
-        return (1);
+        watch.timer = mEventLoop.addTimer(watch.lastConnection + idle, [this, program] { onIdleTimer(program); });
+        return ;
+    }
+    watch.timer = mEventLoop.addTimer(now + idle, [this, program] { onIdleTimer(program); });
+    detach([this, spec = watch.spec] { stopIdle(spec); });
+}
+
+/*
+** stop an idle program, unless one of its processes started within
+** idle_timeout or a connection to its sockets is still open, then wait for
+** a connection. one which came in the meantime is still in the backlog: the
+** program is started again right away.
+*/
+void Supervisor::stopIdle(const std::shared_ptr<const ProgramSpec> & spec)
+{
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    auto group_it = mGroupMap.find(spec->name);
+    auto now = std::chrono::steady_clock::now();
+
+    if (mIsExiting || group_it == mGroupMap.end() || group_it->second.spec != spec)
+    {
+        return ;
     }
-    for (auto it = processes_node.begin(); it != processes_node.end(); ++it)
+    ProcessList processes;
+    for (auto & process : GroupProcesses(group_it->second))
     {
-        // four options:
-        // I:  fatal, go to the next node
-        // II: set default value
-        // III:set incorrect value
-        // IV: if value changed, program should restart
-        bool is_node_valid = false;
-        bool value_changed = false;
-        bool restart = false;
-        std::shared_ptr<Process> new_process = std::make_shared<Process>(Process());
-
-        // options that might trigger a skip
-        new_process->setProcessName(GetYAMLNode<string>(it, "name", &is_node_valid));
-        if (!is_node_valid)
-        {Utils::LogError(mLogFile, "name", "does not exist or is invalid"); continue;}
-
-        auto old_process_it = mProcessMap.find(new_process->getProcessName());
-        if (old_process_it != mProcessMap.end() && !override_existing)
-        {Utils::LogError(mLogFile, new_process->getProcessName(), "already exists in process list."); continue; }
-
-        // get pointer to the existing process if it exists as we might want to restart it
-        auto old_process = (old_process_it == mProcessMap.end()) ?
-            new_process :
-            old_process_it->second;
-
-        // options that might trigger a restart
-        new_process->setFullPath(GetYAMLNode<string>(it, "full_path", old_process->getFullPath(), &is_node_valid, &value_changed));
-        if (!is_node_valid)
-        {Utils::LogError(mLogFile, "full_path", "does not exist or is invalid"); continue;}
-        else if (override_existing && value_changed)
-        {Utils::LogStatus(mLogFile, "restarting process\n"); restart = true;}
-        value_changed = false;
-
-        new_process->setNumberOfRestarts(GetYAMLNode<int>(it, "number_of_restarts", old_process->getNumberOfRestarts(), &is_node_valid, &value_changed));
-        if (!is_node_valid)
-        {new_process->setNumberOfRestarts(1);}
-        else if (override_existing && value_changed && restart == false)
-        {Utils::LogStatus(mLogFile, "restarting process\n"); restart = true;}
-        value_changed = false;
-
-        auto expected_return_node = it->second["expected_return"];
-        if (!expected_return_node)
-        { Utils::LogError(mLogFile, new_process->getProcessName(), "Invalid return value set."); continue; }
-
-        new_process->setExpectedReturns(old_process->getExpectedReturnValues());
-        std::vector<int> return_values;
-        switch(expected_return_node.Type()) {
-        case YAML::NodeType::Scalar:
-            return_values.push_back(expected_return_node.as<int>());
-            value_changed = new_process->setExpectedReturns(return_values);
-            break;
-        case YAML::NodeType::Sequence:
-            for (auto item : expected_return_node)
+        if (!process->isAlive())
+        {
+            continue;
+        }
+        if (now - process->getStartInstant() < Seconds(spec->idleTimeout))
+        {
+            return ;
+        }
+        processes.push_back(process);
+    }
+    bool is_connected = std::any_of(spec->listenSockets.begin(), spec->listenSockets.end(),
+        [](const std::shared_ptr<ListenSocket> & socket) { return socket->countConnections() > 0; });
+    if (processes.empty() || is_connected)
+    {
+        return ;
+    }
+    std::ostringstream message;
+    message << "no connection for " << spec->idleTimeout << "s, stopped until the next one";
+    Utils::LogStatus(mLogFile, spec->name + ": " + message.str() + "\n");
+    emitEvent("idle", nullptr, spec->name + " " + message.str());
+    IGNORE(stopProcesses(processes))
+
+    mEventLoop.post([this, spec] {
+        auto watch = mSocketWatches.find(spec->name);
+        if (watch == mSocketWatches.end() || watch->second.spec != spec)
+        {
+            return ;
+        }
+        watch->second.isWaiting = true;
+        for (auto & socket : spec->listenSockets)
+        {
+            struct pollfd pfd = {socket->getFd(), POLLIN, 0};
+            if (::poll(&pfd, 1, 0) == 1)
             {
-                return_values.push_back(item.as<int>());
+                onConnection(spec->name);
+                return ;
             }
-            value_changed = new_process->setExpectedReturns(return_values);
-            break;
-        default:
-            break;
         }
-        if (!is_node_valid)
-        {Utils::LogError(mLogFile, "expected_return", "does not exist or is invalid"); continue;}
-        else if (override_existing && value_changed)
-        {Utils::LogStatus(mLogFile, "restarting process\n"); restart = true;}
-        value_changed = false;
+    });
+}
+
+/*
+** (re)start the timer of a scheduled program, with this spec. a spec
+** without a schedule only stops it. timers run on the loop thread, which
+** only hands the runs over to another thread (see runJob).
+*/
+void Supervisor::armSchedule(const std::shared_ptr<const ProgramSpec> & spec)
+{
+    mEventLoop.post([this, spec] {
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        auto it = mJobs.find(spec->name);
+        if (it != mJobs.end())
+        {
+            mEventLoop.cancelTimer(it->second.timer);
+            mJobs.erase(it);
+        }
+        if (spec->schedule.empty())
+        {
+            return ;
+        }
+        ScheduledJob job = {spec, {}, 0, 0.0, {}, false};
+        string error;
+        if (Schedule::Parse(spec->schedule, job.schedule, error) != 0)
+        {
+            Utils::LogError(mLogFile, spec->name, error);
+            return ;
+        }
+        scheduleNext(job, job.schedule.next(WallTime()));
+        mJobs[spec->name] = job;
+    });
+}
+
+/*
+** sample the program every autoscale_interval, or stop sampling it if it
+** has no autoscale_metric anymore. the timers are set on the loop thread
+*/
+void Supervisor::armAutoscale(const std::shared_ptr<const ProgramSpec> & spec)
+{
+    mEventLoop.post([this, spec] {
+        // kept while a sample runs, so that a new one does not overlap it
+        AutoscaleWatch & watch = mAutoscaleWatches[spec->name];
+        mEventLoop.cancelTimer(watch.timer);
+        watch.spec = spec;
+        watch.timer = 0;
+        if (spec->autoscaleMetric.empty())
+        {
+            if (!watch.isSampling)
+            {
+                mAutoscaleWatches.erase(spec->name);
+            }
+            return ;
+        }
+        watch.timer = mEventLoop.addTimer(EventLoop::Clock::now() + Seconds(spec->autoscaleInterval),
+            [this, name = spec->name] { onAutoscaleTimer(name); });
+    });
+}
+
+/*
+** on the loop thread: one sample of a program at a time, a slow one delays
+** the next
+*/
+void Supervisor::onAutoscaleTimer(const string & program)
+{
+    auto it = mAutoscaleWatches.find(program);
+
+    if (it == mAutoscaleWatches.end() || mIsExiting)
+    {
+        return ;
+    }
+    AutoscaleWatch & watch = it->second;
+    watch.timer = mEventLoop.addTimer(EventLoop::Clock::now() + Seconds(watch.spec->autoscaleInterval),
+        [this, program] { onAutoscaleTimer(program); });
+    if (watch.isSampling)
+    {
+        return ;
+    }
+    watch.isSampling = true;
+    detach([this, spec = watch.spec] {
+        _autoscale(spec);
+        mEventLoop.post([this, name = spec->name] {
+            auto it = mAutoscaleWatches.find(name);
+            if (it == mAutoscaleWatches.end())
+            {
+                return ;
+            }
+            it->second.isSampling = false;
+            if (it->second.timer == 0)
+            {
+                mAutoscaleWatches.erase(it);
+            }
+        });
+    });
+}
+
+/*
+** on the loop thread, under mJobMutex
+*/
+void Supervisor::scheduleNext(ScheduledJob & job, double due)
+{
+    job.due = due;
+    job.timer = 0;
+    if (due < 0.0)
+    {
+        Utils::LogError(mLogFile, job.spec->name, "schedule: " + job.spec->schedule + " never runs");
+        return ;
+    }
+    double jitter = std::uniform_real_distribution<double>(0.0, job.spec->scheduleJitter)(mRandom);
+    double delay = std::max(0.0, due + jitter - WallTime());
+    job.deadline = EventLoop::Clock::now() + std::chrono::duration_cast<EventLoop::Clock::duration>(
+        std::chrono::duration<double>(delay));
+    job.timer = mEventLoop.addTimer(job.deadline, [this, name = job.spec->name] { onScheduleTimer(name); });
+}
+
+/*
+** on the loop thread. a timer which goes off closer to the next run than to
+** its own (the supervisor was stopped, the machine suspended...) missed its
+** run, and every run since: made up by a single one with schedule_catch_up
+*/
+void Supervisor::onScheduleTimer(const string & program)
+{
+    std::lock_guard<std::mutex> lock(mJobMutex);
+    auto it = mJobs.find(program);
+
+    if (it == mJobs.end() || mIsExiting)
+    {
+        return ;
+    }
+    ScheduledJob & job = it->second;
+    double next = job.schedule.next(job.due);
+    double late = std::chrono::duration<double>(EventLoop::Clock::now() - job.deadline).count();
+    bool is_missed = next >= 0.0 && late > (next - job.due) / 2;
+    size_t n_missed = is_missed;
+    for (double now = WallTime(); next >= 0.0 && next <= now; next = job.schedule.next(next))
+    {
+        ++n_missed;
+    }
+
+    if (!is_missed || job.spec->scheduleCatchUp)
+    {
+        if (is_missed)
+        {
+            Utils::LogStatus(mLogFile, program + ": schedule: catching up " + std::to_string(n_missed) + " missed run(s)\n");
+        }
+        detach([this, program, is_missed] { runJob(program, (is_missed) ? "catch-up" : "scheduled"); });
+    }
+    else
+    {
+        Utils::LogError(mLogFile, program, "schedule: missed " + std::to_string(n_missed) + " run(s)");
+    }
+    scheduleNext(job, next);
+}
 
-        // setValuesWithNoErrorChecking
-        new_process->setStartTime(GetYAMLNode<double>(it, "start_time", &is_node_valid));
-        new_process->setRedirectStreams(GetYAMLNode<bool>(it, "redirect_streams", &is_node_valid));
-        new_process->setOutputRedirectPath(GetYAMLNode<string>(it, "output_redirect_path", &is_node_valid));
-        new_process->setExecOnStartup(GetYAMLNode<bool>(it, "exec_on_startup", &is_node_valid));
-        // see Process.hpp for possible values and usage
-        new_process->setShouldRestart(GetYAMLNode<int>(it, "should_restart", &is_node_valid));
-        new_process->setWorkingDir(GetYAMLNode<string>(it, "working_directory", old_process->getWorkingDir(), &is_node_valid, &value_changed));
-        new_process->setKillSignal(GetYAMLNode<int>(it, "kill_signal", 0, &is_node_valid, &value_changed, SIGTERM));
-        new_process->setUmask(GetYAMLNode<int>(it, "umask", 0, &is_node_valid, &value_changed, -1));
-        new_process->setForceQuitWaitTime(GetYAMLNode<double>(it, "force_quit_wait_time", 0, &is_node_valid, &value_changed, 0.0));
-        is_node_valid = false;
+/*
+** start the processes of a scheduled program, unless they still run from the
+** previous time: then the run is skipped, queued, or the previous one is
+** stopped first, as schedule_overlap says
+*/
+void Supervisor::runJob(const string & program, const string & reason)
+{
+    std::lock_guard<std::mutex> lock(mCommandMutex);
+    auto group_it = mGroupMap.find(program);
 
-        auto start_command = it->second["start_command"];
-        for (auto c : start_command) {
-            new_process->appendCommandArgument(c.as<string>());
+    if (mIsExiting || group_it == mGroupMap.end())
+    {
+        return ;
+    }
+    ProcessList & instances = group_it->second.instances;
+    const string & overlap = group_it->second.spec->scheduleOverlap;
+    bool is_running = std::any_of(instances.begin(), instances.end(),
+        [](const std::shared_ptr<Process> & p) { return p->isAlive(); });
+    if (is_running && overlap == "skip")
+    {
+        Utils::LogError(mLogFile, program, "schedule: the previous run is still running, skipped");
+        return ;
+    }
+    if (is_running && overlap == "queue")
+    {
+        std::lock_guard<std::mutex> job_lock(mJobMutex);
+        auto job = mJobs.find(program);
+        if (job != mJobs.end())
+        {
+            job->second.isQueued = true;
         }
+        Utils::LogStatus(mLogFile, program + ": schedule: queued after the previous run\n");
+        return ;
+    }
+    if (is_running)
+    {
+        Utils::LogStatus(mLogFile, program + ": schedule: stopping the previous run\n");
+        IGNORE(stopProcesses(instances))
+    }
+    Utils::LogStatus(mLogFile, program + ": " + reason + " run\n");
+    emitEvent("schedule", nullptr, program + " " + reason + " run");
+    IGNORE(startProcesses(instances))
+}
+
+/*
+** once the monitor of a process is done with it: a queued run can go
+*/
+void Supervisor::onRunEnd(const std::shared_ptr<Process> & process)
+{
+    const auto spec = process->getSpec();
+    const string & program = spec->name;
+    bool is_queued = false;
 
-        auto env_vars = it->second["additional_env"];
-        char** env_ptr = mInitialEnvironment;
-        if (env_vars){
-            SetProcessEnvironment(new_process, env_vars, env_ptr);
+    if (spec->jobPoolSize > 0)
+    {
+        finishJob(process);
+        return ;
+    }
+    if (spec->schedule.empty())
+    {
+        return ;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        auto job = mJobs.find(program);
+        if (job != mJobs.end())
+        {
+            is_queued = job->second.isQueued;
+            job->second.isQueued = false;
         }
+    }
+    if (is_queued)
+    {
+        runJob(program, "queued");
+    }
+}
+
+/*
+** after each exit, for runs
+*/
+void Supervisor::recordRun(const Process & process)
+{
+    const size_t RunHistorySize = 20;
+    RunRecord record = {
+        process.getProcessName(),
+        process.getExecTime(),
+        std::chrono::duration<double>(process.getExitTime() - process.getStartInstant()).count(),
+        process.getReturnValue(),
+        process.getLastSignal()
+    };
+
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    auto & runs = mRunHistory[process.getSpec()->name];
+    runs.push_back(record);
+    if (runs.size() > RunHistorySize)
+    {
+        runs.pop_front();
+    }
+}
+
+/*
+** a reload applies to the next jobs, the running ones keep the spec they
+** were started with. a program which is no longer a pool drops its queue.
+*/
+void Supervisor::updatePool(const std::shared_ptr<const ProgramSpec> & spec)
+{
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    auto pool_it = mPools.find(spec->name);
 
-        // if we want to create multiple processes, we create copies and give them each a unique name
-        //  give it a unique name and add it to mProcessMap
-        int n_processes = GetYAMLNode<int>(it, "number_of_processes", &is_node_valid);
-        if (is_node_valid && n_processes > 1)
+    if (spec->jobPoolSize == 0)
+    {
+        if (pool_it == mPools.end())
         {
-            AddMultipleProcessesToList(n_processes, mProcessMap, new_process);
+            return ;
         }
-        else
+        if (!pool_it->second.queue.empty())
         {
-            mProcessMap[new_process->getProcessName()] = new_process;
+            Utils::LogError(mLogFile, spec->name, "no longer a job pool, " +
+                std::to_string(pool_it->second.queue.size()) + " queued job(s) dropped");
+            pool_it->second.queue.clear();
         }
+        pool_it->second.spec = spec;
+        return ;
+    }
+    JobPool & pool = mPools[spec->name];
+    pool.spec = spec;
+    pool.isRemoved = false;
+    dispatchJobs(pool);
+}
 
-        if (restart)
+/*
+** start queued jobs while the pool has free slots. each job runs a process
+** of its own, <program>_job_<id>, from a copy of the spec with its
+** arguments and environment. mPoolMutex is held.
+*/
+void Supervisor::dispatchJobs(JobPool & pool)
+{
+    while (!mIsExiting && !pool.queue.empty() && (int)pool.running.size() < pool.spec->jobPoolSize)
+    {
+        PoolJob job = std::move(pool.queue.front());
+        pool.queue.pop_front();
+
+        ProgramSpec spec = *pool.spec;
+        spec.commandArguments.insert(spec.commandArguments.end(), job.arguments.begin(), job.arguments.end());
+        for (auto & [key, value] : job.environment)
         {
-            new_process->stop();
-            _start(new_process);
+            spec.environment.set(key, value);
         }
+        job.process = std::make_shared<Process>(std::make_shared<const ProgramSpec>(std::move(spec)),
+            pool.spec->name + "_job_" + std::to_string(job.id));
+        job.wait = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.submitTime).count();
+        mMetrics.jobWait->observe(job.wait);
+        mMetrics.processes->add(job.process->getState());
+        pool.running.push_back(std::move(job));
+        startProcess(pool.running.back().process);
     }
-    mIsConfigValid = (mProcessMap.size() > 0);
-    return (0);
 }
 
-// 
-// kills all active processes, returns the number of killed
-//
-int Supervisor::killAllProcesses()
+/*
+** a job exited, or was stopped: its slot goes to the next queued one
+*/
+void Supervisor::finishJob(const std::shared_ptr<Process> & process)
+{
+    const size_t FinishedJobsSize = 20;
+    std::ostringstream details;
+
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    auto pool_it = mPools.find(process->getSpec()->name);
+    if (pool_it == mPools.end())
+    {
+        return ;
+    }
+    JobPool & pool = pool_it->second;
+    auto job = std::find_if(pool.running.begin(), pool.running.end(),
+        [&process](const PoolJob & j) { return j.process == process; });
+    if (job == pool.running.end())
+    {
+        return ;
+    }
+    details << std::fixed << std::setprecision(3) << "job " << job->id << " "
+            << ((process->getLastSignal()) ?
+                "signal " + std::to_string(process->getLastSignal()) :
+                "exit " + std::to_string(process->getReturnValue()))
+            << " after " << std::chrono::duration<double>(process->getExitTime() - process->getStartInstant()).count()
+            << "s, waited " << job->wait << "s";
+    Utils::LogStatus(mLogFile, process->getProcessName() + ": " + details.str() + "\n");
+    emitEvent("job", process.get(), details.str());
+    mMetrics.processes->add(process->getState(), -1);
+
+    pool.finished.push_back(std::move(*job));
+    pool.running.erase(job);
+    if (pool.isRemoved && pool.running.empty())
+    {
+        mPools.erase(pool_it);
+        return ;
+    }
+    if (pool.finished.size() > FinishedJobsSize)
+    {
+        pool.finished.pop_front();
+    }
+    dispatchJobs(pool);
+}
+
+void Supervisor::configError(const string & program, const string & field, const string & reason)
+{
+    Utils::LogError(mLogFile, program, field + ": " + reason);
+    mConfigErrors[mLoadingFragment].push_back({program, field, reason});
+}
+
+std::vector<ValidationIssue> Supervisor::getConfigErrors() const
+{
+    std::vector<ValidationIssue> errors;
+
+    for (auto & [path, issues] : mConfigErrors)
+    {
+        errors.insert(errors.end(), issues.begin(), issues.end());
+    }
+    return errors;
+}
+
+/*
+** a program not defined anymore: its processes and jobs are stopped, and
+** everything kept under its name is forgotten. sockets are closed once the
+** last process holding its spec is gone.
+*/
+void Supervisor::removeProgram(const string & name)
 {
-    int n = 0;
-    for (auto & [key, process] : mProcessMap)
+    ProcessGroup & group = mGroupMap.at(name);
+    ProcessList processes = GroupProcesses(group);
+    ProcessList jobs;
+
+    Utils::LogStatus(mLogFile, name + ": removed from the config\n");
+    emitEvent("removed", nullptr, name);
+    IGNORE(stopProcesses(processes))
+    for (auto & process : processes)
     {
-        if (process.get() != nullptr && process->isAlive())
+        mProcessMap.erase(process->getProcessName());
+        mNameIndex.erase(process->getProcessName());
+        retireProcess(process);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mPoolMutex);
+        auto pool_it = mPools.find(name);
+        if (pool_it != mPools.end())
         {
-            process->kill();
-            Utils::LogStatus(mLogFile, "killing " + key + "\n");
-            n++;
+            pool_it->second.queue.clear();
+            pool_it->second.isRemoved = true;
+            for (auto & job : pool_it->second.running)
+            {
+                jobs.push_back(job.process);
+            }
+            if (jobs.empty())
+            {
+                mPools.erase(pool_it);
+            }
         }
     }
-    return (n);
+    IGNORE(stopProcesses(jobs))
+    std::erase_if(mListenSockets, [&name](const auto & entry) { return entry.second.program == name; });
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mRunHistory.erase(name);
+    }
+    mEventLoop.post([this, name] {
+        disarmSocketWatch(name);
+        auto watch = mAutoscaleWatches.find(name);
+        if (watch != mAutoscaleWatches.end())
+        {
+            mEventLoop.cancelTimer(watch->second.timer);
+            watch->second.timer = 0;
+            if (!watch->second.isSampling)
+            {
+                mAutoscaleWatches.erase(watch);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        auto job = mJobs.find(name);
+        if (job != mJobs.end())
+        {
+            mEventLoop.cancelTimer(job->second.timer);
+            mJobs.erase(job);
+        }
+    });
+    mNameIndex.erase(name);
+    mGroupMap.erase(name);
+}
+
+/*
+** grow or shrink the replicas and the spares of a group to its spec. every
+** process shares the group's spec, the first replica keeps the program name,
+** the others are named <name>_<index>, the spares <name>_spare_<index>.
+** removed processes are stopped, added ones are started if the group is running.
+*/
+void Supervisor::scaleGroup(ProcessGroup & group)
+{
+    bool is_running = std::any_of(group.instances.begin(), group.instances.end(),
+        [](const std::shared_ptr<Process> & p) { return p->isAlive(); });
+
+    auto resize = [&] (ProcessList & processes, size_t n, bool is_spare) {
+        if (processes.size() > n)
+        {
+            // whatever their state, so that no run of theirs starts them again
+            ProcessList removed(processes.begin() + n, processes.end());
+            IGNORE(stopProcesses(removed))
+            for (auto & process : removed)
+            {
+                mProcessMap.erase(process->getProcessName());
+                mNameIndex.erase(process->getProcessName());
+                retireProcess(process);
+            }
+            processes.resize(n);
+        }
+        while (processes.size() < n)
+        {
+            size_t index = processes.size();
+            auto name = (is_spare) ?
+                GetUniqueName(group.spec->name + "_spare", index) :
+                (index == 0) ? group.spec->name : GetUniqueName(group.spec->name, index);
+            auto process = std::make_shared<Process>(group.spec, name);
+            process->setIsSpare(is_spare);
+            processes.push_back(process);
+            mProcessMap[name] = process;
+            mNameIndex.insert(name);
+            mMetrics.processes->add(process->getState());
+            if (mStatusTable.isOpen())
+            {
+                process->setStatusSlot(mStatusTable.acquire());
+                publishStatus(*process);
+            }
+            if (is_running)
+            {
+                startProcess(process);
+            }
+        }
+    };
+    resize(group.instances, std::max(group.replicas, 0), false);
+    resize(group.spares, std::max(group.spec->warmSpares, 0), true);
 }
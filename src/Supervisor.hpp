@@ -1,17 +1,258 @@
 #pragma once
 
+#include "Autoscaler.hpp"
+#include "CommandParser.hpp"
+#include "ConfigLoader.hpp"
+#include "ControlServer.hpp"
+#include "DependencyGraph.hpp"
+#include "EventLoop.hpp"
+#include "Metrics.hpp"
+#include "NameIndex.hpp"
 #include "Process.hpp"
+#include "Schedule.hpp"
+#include "StatusQuery.hpp"
+#include "StatusTable.hpp"
+#include "Validator.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
 
 using std::string;
 
+/*
+** command line options (see Utils::PrintHelp)
+*/
+typedef struct SupervisorOptions {
+    string configPath;
+    string configDir;
+    string logFilePath;
+    // control socket, not served if empty
+    string socketPath;
+    // shared memory status table (see StatusTable.hpp), not published if empty
+    string statusShmName;
+    // metrics endpoint: a loopback port or a unix socket path, not served if empty
+    string metricsAddress;
+    // commands run once everything is started, see Supervisor::runBatch
+    string batchPath;
+    // false with --daemon or --foreground: no REPL, exit on SIGTERM or SIGINT
+    bool isInteractive = true;
+    // --daemon: written to once started, see Daemon::Ready
+    int readyFd = -1;
+    // --check: the config is loaded, nothing is bound, started nor written
+    bool isDryRun = false;
+} SupervisorOptions;
+
+/*
+** a config entry and the replicas started from it
+*/
+typedef struct ProcessGroup {
+    std::shared_ptr<const ProgramSpec> spec;
+    // the config file it was defined in
+    string fragment;
+    std::vector<std::shared_ptr<Process> > instances;
+    // warm_spares, named <name>_spare_<index>. a promoted spare and the
+    //  replica it replaces swap their names and places
+    std::vector<std::shared_ptr<Process> > spares;
+    // number_of_processes, or what the autoscaler asked for
+    int replicas = 0;
+} ProcessGroup;
+
+typedef std::vector<std::shared_ptr<Process> > ProcessList;
+
+// options and arguments of the command are read from the parser
+typedef std::function<int(ProcessList&, std::ostream&)> CommandHandler;
+
+class MetricsServer;
+
+/*
+** the metrics updated by the supervisor, owned by its registry
+*/
+typedef struct SupervisorMetrics {
+    Metrics::Counter *spawns;
+    Metrics::Counter *spawnFailures;
+    Metrics::Histogram *spawnLatency;
+    Metrics::Histogram *readyLatency;
+    Metrics::Counter *readyTimeouts;
+    Metrics::Family *exitCodes;
+    Metrics::Family *exitSignals;
+    Metrics::Counter *restarts;
+    Metrics::Counter *backoffs;
+    Metrics::Counter *promotions;
+    Metrics::Counter *autoscales;
+    Metrics::Counter *jobsSubmitted;
+    Metrics::Counter *jobsRejected;
+    Metrics::Histogram *jobWait;
+    Metrics::Histogram *stopLatency;
+    Metrics::Histogram *reloadDuration;
+    Metrics::Counter *commands;
+    Metrics::Histogram *commandDuration;
+    Metrics::Family *processes;
+} SupervisorMetrics;
+
+/*
+** how a process went down, see Supervisor::stopAll
+*/
+typedef struct StopResult {
+    std::shared_ptr<Process> process;
+    // seconds between the stop signal and the exit
+    double latency;
+    bool killed;
+} StopResult;
+
+/*
+** a rolling-restart in progress, see Supervisor::rollingRestart
+*/
+typedef struct RollingRestart {
+    string group;
+    // the replicas which were running, in order
+    ProcessList processes;
+    // restarted once every replica is
+    ProcessList spares;
+    size_t batch;
+    size_t maxUnavailable;
+    // seconds for a restarted replica to be READY
+    double timeout;
+} RollingRestart;
+
+/*
+** the sockets of a lazy_start or idle_timeout program, watched on the loop
+** thread, see Supervisor::armSocketWatch
+*/
+typedef struct SocketWatch {
+    std::shared_ptr<const ProgramSpec> spec;
+    // the next connection starts the program
+    bool isWaiting;
+    EventLoop::Clock::time_point lastConnection;
+    // the next idle_timeout check, 0 if none
+    EventLoop::TimerId timer;
+} SocketWatch;
+
+/*
+** a program with an autoscale_metric, see Supervisor::armAutoscale. only used
+** on the loop thread
+*/
+typedef struct AutoscaleWatch {
+    std::shared_ptr<const ProgramSpec> spec;
+    // the next sample, 0 if none
+    EventLoop::TimerId timer;
+    // a sample runs on its own thread, the next one waits for it
+    bool isSampling;
+} AutoscaleWatch;
+
+/*
+** a program with a schedule, see Supervisor::armSchedule
+*/
+typedef struct ScheduledJob {
+    std::shared_ptr<const ProgramSpec> spec;
+    Schedule schedule;
+    EventLoop::TimerId timer;
+    // the time of the next run (wall clock), and when the timer goes off for
+    //  it, jitter included
+    double due;
+    EventLoop::Clock::time_point deadline;
+    // a run waits for the previous one to exit (schedule_overlap: queue)
+    bool isQueued;
+} ScheduledJob;
+
+/*
+** an exit of a process, kept in the history of its program (see runs)
+*/
+typedef struct RunRecord {
+    string process;
+    // wall clock
+    long double startTime;
+    double duration;
+    int exitCode;
+    int signal;
+} RunRecord;
+
+/*
+** an invocation submitted to a job pool, see Supervisor::submit
+*/
+typedef struct PoolJob {
+    uint64_t id;
+    // appended to start_command
+    std::vector<string> arguments;
+    // set over the program's environment
+    std::vector<std::pair<string, string> > environment;
+    std::chrono::steady_clock::time_point submitTime;
+    // <program>_job_<id>, once started. its exit code and run time are
+    //  read from it once it finished
+    std::shared_ptr<Process> process;
+    // seconds from the submission to the start
+    double wait;
+} PoolJob;
+
+/*
+** the jobs of a program with job_pool_size, oldest first
+*/
+typedef struct JobPool {
+    std::shared_ptr<const ProgramSpec> spec;
+    std::deque<PoolJob> queue;
+    std::vector<PoolJob> running;
+    // the last ones, for jobs
+    std::deque<PoolJob> finished;
+    // removed from the config, forgotten once its running jobs are done
+    bool isRemoved = false;
+} JobPool;
+
+/*
+** what startInOrder did with a program, for boot-report. times are seconds
+** since the boot began, -1 until they happen
+*/
+typedef struct BootProgram {
+    string name;
+    // its priority, or that of a dependency which starts later
+    int priority;
+    // when its launch is due, from the start of its class
+    double offset;
+    double launched;
+    double done;
+    // 1 ready, -1 failed or not started, 0 meanwhile
+    int status;
+    string note;
+} BootProgram;
+
+typedef struct BootClass {
+    int priority;
+    // the largest start_delay of its programs
+    double window;
+    double opened;
+    double closed;
+    // why the next class started: "ready" or "window expired"
+    string reason;
+} BootClass;
+
+typedef struct BootReport {
+    std::vector<BootClass> classes;
+    // by class, then by dependency level
+    std::vector<BootProgram> programs;
+    // -1 while booting
+    double duration = -1.0;
+} BootReport;
+
+/*
+** a socket bound for a program (see ListenSocket), which lives as long as a
+** spec holds it: a reload which keeps the address keeps the socket
+*/
+typedef struct BoundSocket {
+    string program;
+    std::weak_ptr<ListenSocket> socket;
+} BoundSocket;
+
 class Supervisor {
     public:
 
@@ -19,49 +260,174 @@ class Supervisor {
         ** xtors
         */
         Supervisor();
-        Supervisor(const string config_path, const string log_file_path, char *env[]);
+        Supervisor(const SupervisorOptions & options, char *env[]);
         ~Supervisor();
 
         /*
         ** business logic
         */
-        int loadConfig(const string & config_path, bool override_existing = false);
+        int loadConfig(bool override_existing = false);
         int isConfigValid();
+        int checkConfig(std::ostream & out);
         void init();
         void restart();
+        int executeCommand(const string & line, std::ostream & out);
     private:
 
         /*
         ** private functions
         */
-        int killAllProcesses();
+        int stopAllProcesses(std::ostream & out);
+        void stopAll(const ProcessList & processes, std::vector<StopResult> & results);
+        string configDescription() const;
+        void configError(const string & program, const string & field, const string & reason);
+        std::vector<ValidationIssue> getConfigErrors() const;
+        void requestExit();
+        int runBatch(const string & path);
+        void runInterpreter();
+        void waitForExit();
+        bool wakeUp();
+        std::vector<string> complete(const string & before, const string & word);
+        int startServers();
+        void stopServers();
+        void registerMetrics();
+
+        void scaleGroup(ProcessGroup & group);
+        void removeProgram(const string & name);
+        void retireProcess(const std::shared_ptr<Process> & process);
+        void leaveRun(const std::shared_ptr<Process> & process);
+        bool promoteSpare(std::shared_ptr<Process> & process, uint64_t run);
+        void setState(const std::shared_ptr<Process> & process, ProcessState state);
+        void publishStatus(const Process & process);
+        void emitEvent(const string & kind, const Process * process, const string & details);
+        void addCommand(const CommandSpec & spec, const CommandHandler & handler);
+        int resolveTargets(const std::vector<std::string_view> & args, ProcessList & targets, std::ostream & out);
+        int startProcess(std::shared_ptr<Process> & process);
+        void startInOrder(const std::vector<string> & programs);
+        void waitForBoot();
+        int programReadiness(const string & program);
+        void buildDependencyGraph();
+        int bindSockets(ProgramSpec & spec);
+        void armSocketWatch(const std::shared_ptr<const ProgramSpec> & spec);
+        void disarmSocketWatch(const string & program);
+        void onConnection(const string & program);
+        void onIdleTimer(const string & program);
+        void stopIdle(const std::shared_ptr<const ProgramSpec> & spec);
+        void armAutoscale(const std::shared_ptr<const ProgramSpec> & spec);
+        void onAutoscaleTimer(const string & program);
+        void armSchedule(const std::shared_ptr<const ProgramSpec> & spec);
+        void scheduleNext(ScheduledJob & job, double due);
+        void onScheduleTimer(const string & program);
+        void runJob(const string & program, const string & reason);
+        void onRunEnd(const std::shared_ptr<Process> & process);
+        void updatePool(const std::shared_ptr<const ProgramSpec> & spec);
+        void dispatchJobs(JobPool & pool);
+        void finishJob(const std::shared_ptr<Process> & process);
+        void recordRun(const Process & process);
+        int stopProcess(std::shared_ptr<Process> & process);
 
-        void _start(std::shared_ptr<Process> & process);
+        void _start(std::shared_ptr<Process> process, uint64_t run);
+        void _awaitReady(std::shared_ptr<Process> & process, uint64_t run);
         int _monitor(std::shared_ptr<Process> & process);
+        void _autoscale(std::shared_ptr<const ProgramSpec> spec);
 
         /*
         ** functions called by REPL
         */
-        int startProcess(std::shared_ptr<Process> & process);
-        int restartProcess(std::shared_ptr<Process> & process);
-        int stopProcess(std::shared_ptr<Process> & process);
-        int getProcessStatus(std::shared_ptr<Process> & process);
+        int startProcesses(ProcessList & processes);
+        int restartProcesses(ProcessList & processes);
+        int rollingRestart(ProcessList & processes, std::ostream & out);
+        void rollOut(const RollingRestart & plan);
+        void detach(std::function<void()> task);
+        int stopProcesses(ProcessList & processes);
+        int getProcessStatus(ProcessList & processes, std::ostream & out);
+        int pushMetric(ProcessList & processes, std::ostream & out);
+        int runs(ProcessList & processes, std::ostream & out);
+        int submit(ProcessList & processes, std::ostream & out);
+        int jobs(ProcessList & processes, std::ostream & out);
+        int bootReport(ProcessList & processes, std::ostream & out);
 
-        /* process param can be ignored in these functions */
-        int printHelp(std::shared_ptr<Process> & process);
-        int reloadConfig(std::shared_ptr<Process> &process);
-        int exit(std::shared_ptr<Process> &process);
-        int history(std::shared_ptr<Process> &process);
-        int listProcesses(std::shared_ptr<Process> &process);
+        /* processes param is empty for these functions */
+        int printHelp(ProcessList & processes, std::ostream & out);
+        int reloadConfig(ProcessList & processes);
+        int exit(ProcessList & processes, std::ostream & out);
+        int history(ProcessList & processes, std::ostream & out);
+        int listProcesses(ProcessList & processes, std::ostream & out);
+        int validate(ProcessList & processes, std::ostream & out);
 
         /*
         ** class members
         */
         bool mIsConfigValid;
-        string mConfigFilePath;
+        SupervisorOptions mOptions;
         string mLogFilePath;
-        char ** mInitialEnvironment;
+        std::shared_ptr<const EnvironmentBlock> mBaseEnvironment;
         std::fstream mLogFile;
+        ConfigLoader mConfigLoader;
+        // errors found while loading, by fragment path; a reload only replaces
+        // those of the fragments it read again. "" holds the ones of no single
+        // fragment: unparsable files, duplicate names and the graph-wide ones
+        std::map<string, std::vector<ValidationIssue> > mConfigErrors;
+        string mLoadingFragment;
+        std::unordered_map<string, ProcessGroup> mGroupMap;
+        DependencyGraph mDependencyGraph;
+        // sampled by _autoscale
+        Autoscaler mAutoscaler;
+        // by address
+        std::unordered_map<string, BoundSocket> mListenSockets;
+        StatusTable mStatusTable;
+        MetricsRegistry mMetricsRegistry;
+        SupervisorMetrics mMetrics;
         std::unordered_map<string, std::shared_ptr<Process> > mProcessMap;
-        std::unordered_map<string, std::function<int(std::shared_ptr<Process>&)> > mCommandMap;
+        // names of mGroupMap and mProcessMap, in order
+        NameIndex mNameIndex;
+        // guarded by mCommandMutex
+        CommandParser mCommandParser;
+        // indexed by CommandSpec::id
+        std::vector<CommandHandler> mCommandHandlers;
+        StatusQuery mStatusQuery;
+        string mStatusBuffer;
+        std::mutex mCommandMutex;
+
+        // control socket
+        EventLoop mEventLoop;
+        std::thread mEventLoopThread;
+        std::unique_ptr<ControlServer> mControlServer;
+        // guards mControlServer against events published while it comes and goes
+        std::mutex mEventMutex;
+        std::unique_ptr<MetricsServer> mMetricsServer;
+        // lazy_start and idle_timeout programs. only used on the loop thread
+        std::unordered_map<string, SocketWatch> mSocketWatches;
+        // autoscaled programs, only used on the loop thread
+        std::unordered_map<string, AutoscaleWatch> mAutoscaleWatches;
+        // timers are set on the loop thread, the rest is read by commands too
+        std::mutex mJobMutex;
+        std::unordered_map<string, ScheduledJob> mJobs;
+        // schedule_jitter, only used on the loop thread
+        std::mt19937 mRandom;
+        // job pools by program, see submit
+        std::mutex mPoolMutex;
+        std::unordered_map<string, JobPool> mPools;
+        uint64_t mNextJobId;
+        // written to wake the main thread up when exit or a reload is requested
+        int mWakeFd;
+        std::atomic<bool> mIsExiting;
+        std::atomic<bool> mIsReloadRequested;
+
+        // bumped on each state change, see startInOrder
+        std::mutex mStateMutex;
+        std::condition_variable mStateCondition;
+        uint64_t mStateVersion;
+        // detached threads still running, see detach()
+        size_t mNumberOfThreads;
+        // _start threads still running, by process. the processes removed from
+        //  their group keep their status slot until theirs are done, see retireProcess
+        std::unordered_map<const Process *, int> mRunThreads;
+        ProcessList mRetiredProcesses;
+        // groups being rolled out
+        std::unordered_set<string> mRollingGroups;
+        // the last exits of each program, oldest first
+        std::unordered_map<string, std::deque<RunRecord> > mRunHistory;
+        // written by startInOrder as the boot goes
+        BootReport mBootReport;
 };
@@ -1,6 +1,9 @@
 #include "Utils.hpp"
+#include <atomic>
+#include <csignal>
 #include <string>
 #include <fstream>
+#include <thread>
 
 namespace Utils {
 
@@ -58,20 +61,50 @@ std::vector<std::string> SplitString(
     const string &separator)
 {
     std::vector<std::string> out;
-    int last_separator_pos = 0;
+    size_t begin = 0, end;
 
-    while (source.find(separator) != std::string::npos)
+    // one pass, without erasing from the front of source
+    while ((end = source.find(separator, begin)) != std::string::npos)
     {
-        out.push_back(source.substr(last_separator_pos, source.find(separator)));
-        source.erase(0, source.find(separator) + separator.length());
+        out.push_back(source.substr(begin, end - begin));
+        begin = end + separator.length();
     }
-    if (source.size() != 0)
+    if (begin < source.size())
     {
-        out.push_back(source);
+        out.push_back(source.substr(begin));
     }
     return out;
 }
 
+void ParallelFor(size_t n, const std::function<void(size_t)> & task)
+{
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    size_t n_workers = std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+
+    if (n_workers <= 1)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            task(i);
+        }
+        return ;
+    }
+    for (size_t w = 0; w < n_workers; ++w)
+    {
+        workers.emplace_back([&next, &task, n] {
+            for (size_t i = next++; i < n; i = next++)
+            {
+                task(i);
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
 char * GetCommandLineOption(int ac, char *av[], const string &option_flag)
 {
     for (int i = 0; i < ac; ++i)
@@ -84,13 +117,62 @@ char * GetCommandLineOption(int ac, char *av[], const string &option_flag)
     return NULL;
 }
 
+bool HasCommandLineFlag(int ac, char *av[], const string &flag)
+{
+    for (int i = 0; i < ac; ++i)
+    {
+        if (std::string(av[i]) == flag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int SignalFromString(const string & name)
+{
+    static const std::pair<const char *, int> signals[] = {
+        {"HUP", SIGHUP}, {"INT", SIGINT}, {"QUIT", SIGQUIT}, {"ILL", SIGILL},
+        {"TRAP", SIGTRAP}, {"ABRT", SIGABRT}, {"BUS", SIGBUS}, {"FPE", SIGFPE},
+        {"KILL", SIGKILL}, {"USR1", SIGUSR1}, {"SEGV", SIGSEGV}, {"USR2", SIGUSR2},
+        {"PIPE", SIGPIPE}, {"ALRM", SIGALRM}, {"TERM", SIGTERM}, {"CHLD", SIGCHLD},
+        {"CONT", SIGCONT}, {"STOP", SIGSTOP}, {"TSTP", SIGTSTP}, {"TTIN", SIGTTIN},
+        {"TTOU", SIGTTOU}, {"URG", SIGURG}, {"XCPU", SIGXCPU}, {"XFSZ", SIGXFSZ},
+        {"VTALRM", SIGVTALRM}, {"PROF", SIGPROF}, {"WINCH", SIGWINCH}, {"IO", SIGIO},
+        {"SYS", SIGSYS},
+    };
+
+    if (!name.empty() && std::all_of(name.begin(), name.end(), ::isdigit))
+    {
+        return (name.size() < 4) ? std::stoi(name) : -1;
+    }
+    string short_name = (name.rfind("SIG", 0) == 0) ? name.substr(3) : name;
+    for (auto & [n, sig] : signals)
+    {
+        if (short_name == n)
+        {
+            return sig;
+        }
+    }
+    return -1;
+}
+
 int PrintHelp()
 {
     string out =
         "Usage\n  taskmaster [options]\n\nOptions:\n";
     out += "  --help\tprint this help\n";
     out += "  --config-file <path>\tpath to the config file (YAML)\n";
+    out += "  --config-dir <path>\tdirectory of config fragments (*.yaml, *.yml)\n";
     out += "  --log-file <path>\tpath to the output log file\n";
+    out += "  --socket <path>\tserve commands on a unix socket (see taskmasterctl)\n";
+    out += "  --status-shm <name>\tpublish a status table in shared memory, eg: /taskmaster\n";
+    out += "  --metrics <port|path>\tserve prometheus metrics over HTTP on 127.0.0.1:<port> or a unix socket\n";
+    out += "  --daemon\t\tdetach from the terminal, no REPL: control it through --socket and signals\n";
+    out += "  --foreground\t\tno REPL but stay attached, for service managers (systemd, runit...)\n";
+    out += "  --pidfile <path>\twrite the pid to path, refuse to start if another taskmaster holds it\n";
+    out += "  --batch <path>\trun the commands of a file (- for stdin) once started, one per line\n";
+    out += "  --check\t\tvalidate the config and exit\n";
     std::cout << out;
     return (0);
 }
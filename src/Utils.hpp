@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <mutex>
 
 using std::string;
@@ -71,10 +72,22 @@ namespace Utils {
         return out;
     }
 
+    /*
+    ** run task(0) ... task(n - 1) on a transient pool of worker threads,
+    ** returns once every task is done
+    */
+    void ParallelFor(size_t n, const std::function<void(size_t)> & task);
+
     char * GetCommandLineOption(int ac, char *av[], const string &option_flag);
+    bool HasCommandLineFlag(int ac, char *av[], const string &flag);
     int PrintHelp();
     int MissingArgument(const string & argument);
 
+    /*
+    ** "SIGTERM", "TERM" or "15" -> 15, -1 if unknown
+    */
+    int SignalFromString(const string & name);
+
     /*
     ** signal handler
     */
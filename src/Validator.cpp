@@ -0,0 +1,192 @@
+#include "Validator.hpp"
+#include "ProgramSchema.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// anonymous namespace
+namespace {
+
+/*
+** the child chdir()s before execve(), so a relative full_path
+** is looked up from the working directory
+*/
+static auto ExecutablePath(const ProgramSpec & spec) -> string
+{
+    if (spec.fullPath.front() == '/' || spec.workingDir.empty())
+    {
+        return spec.fullPath;
+    }
+    return spec.workingDir + "/" + spec.fullPath;
+}
+
+static auto ParentDirectory(const string & path) -> string
+{
+    auto pos = path.rfind('/');
+    if (pos == string::npos)
+    {
+        return ".";
+    }
+    return path.substr(0, (pos == 0) ? 1 : pos);
+}
+
+static auto CheckFiles(const ProgramSpec & spec, std::vector<ValidationIssue> & out) -> void
+{
+    struct stat st;
+
+    if (!spec.workingDir.empty())
+    {
+        if (::stat(spec.workingDir.c_str(), &st) == -1)
+        {out.push_back({spec.name, "working_directory", spec.workingDir + ": " + std::strerror(errno)});}
+        else if (!S_ISDIR(st.st_mode))
+        {out.push_back({spec.name, "working_directory", spec.workingDir + ": " + std::strerror(ENOTDIR)});}
+        else if (::access(spec.workingDir.c_str(), X_OK) == -1)
+        {out.push_back({spec.name, "working_directory", spec.workingDir + ": " + std::strerror(errno)});}
+    }
+
+    if (spec.fullPath.empty())
+    {out.push_back({spec.name, "full_path", "is empty"});}
+    else
+    {
+        string path = ExecutablePath(spec);
+        if (::stat(path.c_str(), &st) == -1)
+        {out.push_back({spec.name, "full_path", path + ": " + std::strerror(errno)});}
+        else if (S_ISDIR(st.st_mode))
+        {out.push_back({spec.name, "full_path", path + ": " + std::strerror(EISDIR)});}
+        else if (::access(path.c_str(), X_OK) == -1)
+        {out.push_back({spec.name, "full_path", path + ": " + std::strerror(errno)});}
+    }
+
+    if (spec.redirectStreams)
+    {
+        // opened before chdir(), relative to our own working directory
+        const string & path = spec.outputRedirectPath;
+        if (path.empty())
+        {out.push_back({spec.name, "output_redirect_path", "is empty while redirect_streams is set"});}
+        else if (::access(path.c_str(), F_OK) == 0)
+        {
+            if (::access(path.c_str(), W_OK) == -1)
+            {out.push_back({spec.name, "output_redirect_path", path + ": " + std::strerror(errno)});}
+        }
+        else if (::access(ParentDirectory(path).c_str(), W_OK | X_OK) == -1)
+        {out.push_back({spec.name, "output_redirect_path", path + ": " + std::strerror(errno)});}
+    }
+}
+};
+
+namespace Validator {
+
+/*
+** the sockets take fds 3 to 3 + n - 1 in the child
+*/
+std::vector<ValidationIssue> ValidateSockets(const ProgramSpec & spec)
+{
+    std::vector<ValidationIssue> out;
+    int n_sockets = spec.sockets.size();
+
+    if (spec.readyFd != -1 && spec.readyFd < 3 + n_sockets)
+    {out.push_back({spec.name, "ready_fd", "must be " + std::to_string(3 + n_sockets) + " or more, the sockets come first"});}
+    if (spec.lazyStart && spec.sockets.empty())
+    {out.push_back({spec.name, "lazy_start", "needs sockets to wait on"});}
+    if (spec.idleTimeout > 0.0 && spec.sockets.empty())
+    {out.push_back({spec.name, "idle_timeout", "needs sockets to wait on"});}
+    return out;
+}
+
+std::vector<ValidationIssue> ValidateAutoscale(const ProgramSpec & spec)
+{
+    std::vector<ValidationIssue> out;
+
+    if (spec.autoscaleMetric.empty())
+    {
+        return out;
+    }
+    if (spec.autoscaleMax < spec.autoscaleMin)
+    {out.push_back({spec.name, "autoscale_max", "must be at least autoscale_min"});}
+    if (spec.autoscaleMetric == "command" && spec.autoscaleCommand.empty())
+    {out.push_back({spec.name, "autoscale_command", "is empty while autoscale_metric is command"});}
+    return out;
+}
+
+/*
+** a pool has no process of its own to schedule, scale or hold spares of,
+** and its jobs must end
+*/
+std::vector<ValidationIssue> ValidateJobPool(const ProgramSpec & spec)
+{
+    std::vector<ValidationIssue> out;
+
+    if (spec.jobPoolSize == 0)
+    {
+        return out;
+    }
+    if (spec.shouldRestart == ShouldRestart::Always)
+    {out.push_back({spec.name, "should_restart", "can't be 2 (always) for a job pool"});}
+    if (!spec.schedule.empty())
+    {out.push_back({spec.name, "schedule", "can't be set for a job pool"});}
+    if (!spec.autoscaleMetric.empty())
+    {out.push_back({spec.name, "autoscale_metric", "can't be set for a job pool"});}
+    if (spec.warmSpares > 0)
+    {out.push_back({spec.name, "warm_spares", "can't be set for a job pool"});}
+    if (spec.lazyStart)
+    {out.push_back({spec.name, "lazy_start", "can't be set for a job pool"});}
+    if (spec.idleTimeout > 0.0)
+    {out.push_back({spec.name, "idle_timeout", "can't be set for a job pool"});}
+    return out;
+}
+
+std::vector<ValidationIssue> ValidateSpec(const ProgramSpec & spec)
+{
+    std::vector<ValidationIssue> out;
+
+    ProgramSchema::Validate(spec, out);
+    CheckFiles(spec, out);
+    auto sockets = ValidateSockets(spec);
+    out.insert(out.end(), sockets.begin(), sockets.end());
+    auto autoscale = ValidateAutoscale(spec);
+    out.insert(out.end(), autoscale.begin(), autoscale.end());
+    auto pool = ValidateJobPool(spec);
+    out.insert(out.end(), pool.begin(), pool.end());
+    return out;
+}
+
+std::vector<ValidationIssue> ValidatePrograms(
+    const std::vector<std::shared_ptr<const ProgramSpec> > & specs)
+{
+    std::vector<std::vector<ValidationIssue> > results(specs.size());
+    std::vector<ValidationIssue> out;
+
+    Utils::ParallelFor(specs.size(), [&specs, &results](size_t i) {
+        results[i] = ValidateSpec(*specs[i]);
+    });
+    for (auto & r : results)
+    {
+        out.insert(out.end(), r.begin(), r.end());
+    }
+    std::stable_sort(out.begin(), out.end(), [](const ValidationIssue & a, const ValidationIssue & b) {
+        return a.program < b.program;
+    });
+    return out;
+}
+
+size_t Report(
+    std::ostream & out,
+    const std::vector<ValidationIssue> & issues,
+    size_t n_programs)
+{
+    string s = "==== taskmaster config check ====\n";
+
+    for (auto & issue : issues)
+    {
+        s += "[" + issue.program + "] " + issue.field + ": " + issue.message + "\n";
+    }
+    s += std::to_string(n_programs) + " program(s) checked, " +
+        std::to_string(issues.size()) + " error(s)\n";
+    out << s;
+    return issues.size();
+}
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ProgramSpec.hpp"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using std::string;
+
+typedef struct ValidationIssue {
+    string program;
+    string field;
+    string message;
+} ValidationIssue;
+
+/*
+** pre-flight checks, run on loaded specs before anything is started:
+** value ranges, and what would otherwise only fail in the child after fork()
+** (missing binary, unreachable working directory, unwritable redirect path)
+*/
+namespace Validator {
+
+    std::vector<ValidationIssue> ValidateSpec(const ProgramSpec & spec);
+
+    // what Process::start needs to pass the sockets, also checked on load
+    std::vector<ValidationIssue> ValidateSockets(const ProgramSpec & spec);
+
+    // autoscale_* keys which only make sense together, also checked on load
+    std::vector<ValidationIssue> ValidateAutoscale(const ProgramSpec & spec);
+
+    // what a job pool can't be, also checked on load
+    std::vector<ValidationIssue> ValidateJobPool(const ProgramSpec & spec);
+
+    /*
+    ** validate every spec on a pool of worker threads,
+    ** issues are returned sorted by program name
+    */
+    std::vector<ValidationIssue> ValidatePrograms(
+        const std::vector<std::shared_ptr<const ProgramSpec> > & specs);
+
+    /*
+    ** print issues, one line each, followed by a summary line.
+    ** returns the number of issues.
+    */
+    size_t Report(
+        std::ostream & out,
+        const std::vector<ValidationIssue> & issues,
+        size_t n_programs);
+};
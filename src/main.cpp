@@ -1,38 +1,84 @@
+#include <cerrno>
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include "Daemon.hpp"
 #include "Supervisor.hpp"
 #include "Utils.hpp"
 
 int main(int ac, char **av, char *envp[])
 {
-    string config_file, log_file;
+    SupervisorOptions options;
     char * opt = NULL;
-    bool help;
+    bool help, check, daemon, foreground;
+    string pid_file_path;
+    int pid_file = -1;
 
-    help = false;
+    help = Utils::HasCommandLineFlag(ac, av, "--help");
+    check = Utils::HasCommandLineFlag(ac, av, "--check");
+    daemon = Utils::HasCommandLineFlag(ac, av, "--daemon");
+    foreground = Utils::HasCommandLineFlag(ac, av, "--foreground");
     if ((opt = Utils::GetCommandLineOption(ac, av, "--config-file")) != NULL)
-    {config_file = opt;}
+    {options.configPath = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--config-dir")) != NULL)
+    {options.configDir = opt;}
     if ((opt = Utils::GetCommandLineOption(ac, av, "--log-file")) != NULL)
-    {log_file = opt;}
-    if ((opt = Utils::GetCommandLineOption(ac, av, "--help")) != NULL)
-    {help = true;}
+    {options.logFilePath = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--socket")) != NULL)
+    {options.socketPath = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--status-shm")) != NULL)
+    {options.statusShmName = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--metrics")) != NULL)
+    {options.metricsAddress = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--batch")) != NULL)
+    {options.batchPath = opt;}
+    if ((opt = Utils::GetCommandLineOption(ac, av, "--pidfile")) != NULL)
+    {pid_file_path = opt;}
 
     if (help)
     {return Utils::PrintHelp();}
-    if (log_file.empty())
+    if (options.logFilePath.empty() && !check)
     {std::cout << "log file unspecified (--log-file), using default: ./taskmaster.log\n";}
-    if (config_file.empty())
-    {return Utils::MissingArgument("--config-file");}
+    if (options.configPath.empty() && options.configDir.empty())
+    {return Utils::MissingArgument("--config-file or --config-dir");}
 
-    Supervisor s(config_file, log_file, envp);
-    if (!s.isConfigValid())
+    if ((daemon || foreground) && !check)
     {
-        std::cerr << "error: invalid file provided: " << config_file << "\n";
+        options.isInteractive = false;
+    }
+    // before anything is opened or started: the supervisor is the daemon
+    if (daemon && !check && Daemon::Detach(options.readyFd) != 0)
+    {
+        std::cerr << "error: could not detach: " << std::strerror(errno) << "\n";
+        return (1);
+    }
+    if (!pid_file_path.empty() && !check &&
+        (pid_file = Daemon::WritePidFile(pid_file_path)) == -1)
+    {
+        std::cerr << "error: pidfile " << pid_file_path << ": " <<
+            ((errno == EWOULDBLOCK) ? "taskmaster is already running" : std::strerror(errno)) << "\n";
         return (1);
     }
-    else
+
+    int ret = 0;
     {
-        s.init();
+        options.isDryRun = check;
+        Supervisor s(options, envp);
+        if (check)
+        {
+            // dry run: nothing is started
+            return (s.checkConfig(std::cout) == 0 && s.isConfigValid()) ? 0 : 1;
+        }
+        if (!s.isConfigValid())
+        {
+            std::cerr << "error: invalid config provided: " << options.configPath << options.configDir << "\n";
+            ret = 1;
+        }
+        else
+        {
+            s.init();
+        }
     }
-    return 0;
+    Daemon::RemovePidFile(pid_file_path, pid_file);
+    return ret;
 }
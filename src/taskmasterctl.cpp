@@ -0,0 +1,254 @@
+#include "ControlProtocol.hpp"
+#include "ProcessState.hpp"
+#include "StatusTable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+
+namespace {
+
+const char * DefaultSocketPath = "/tmp/taskmaster.sock";
+
+static auto PrintUsage() -> int
+{
+    string out;
+
+    out += "usage: taskmasterctl [--socket <path>] [command...]\n";
+    out += "       taskmasterctl [--socket <path>] --bench <clients> <requests> [command...]\n";
+    out += "       taskmasterctl --status-shm <name>\n";
+    out += "  --socket <path>\tcontrol socket of taskmaster (default: ";
+    out += DefaultSocketPath;
+    out += ")\n";
+    out += "  --bench\t\tsend <requests> commands from each of <clients> connections,\n";
+    out += "\t\t\tthen print throughput and latency (default command: status)\n";
+    out += "  --status-shm\t\tprint the status table taskmaster publishes in shared memory\n";
+    out += "without a command, commands are read from stdin, one per line\n";
+    out += "subscribe [target...] [--events kind,...] prints events as they happen\n";
+    std::cout << out;
+    return 1;
+}
+
+/*
+** send one command and print its output. returns the command's status
+*/
+static auto Execute(int fd, string & buffer, const string & command) -> int
+{
+    string response;
+
+    if (ControlProtocol::SendFrame(fd, command) == -1 ||
+        ControlProtocol::ReceiveFrame(fd, buffer, response) == -1 ||
+        response.empty())
+    {
+        // exit closes the socket as taskmaster goes down
+        if (command == "exit")
+        {
+            return 0;
+        }
+        std::cerr << "taskmasterctl: connection lost\n";
+        return 2;
+    }
+    std::cout.write(response.data() + 1, response.size() - 1);
+    std::cout.flush();
+    if (response[0] != ControlProtocol::Ok)
+    {
+        return 1;
+    }
+    // events follow until taskmaster goes away
+    if (command.rfind("subscribe", 0) == 0)
+    {
+        while (ControlProtocol::ReceiveFrame(fd, buffer, response) == 0 && !response.empty())
+        {
+            std::cout.write(response.data() + 1, response.size() - 1);
+            std::cout.flush();
+        }
+    }
+    return 0;
+}
+
+/*
+** <clients> connections each send <requests> commands back to back
+*/
+static auto Bench(const string & socket_path, int clients, int requests, const string & command) -> int
+{
+    std::vector<std::vector<double> > latencies(clients);
+    std::vector<std::thread> threads;
+    std::atomic<int> failures(0);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([&, i] {
+            int fd = ControlProtocol::Connect(socket_path);
+            string buffer, response;
+
+            if (fd == -1)
+            {
+                ++failures;
+                return ;
+            }
+            latencies[i].reserve(requests);
+            for (int r = 0; r < requests; ++r)
+            {
+                auto start = std::chrono::steady_clock::now();
+                if (ControlProtocol::SendFrame(fd, command) == -1 ||
+                    ControlProtocol::ReceiveFrame(fd, buffer, response) == -1)
+                {
+                    ++failures;
+                    break;
+                }
+                latencies[i].push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            ::close(fd);
+        });
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<double> all;
+    for (auto & l : latencies)
+    {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    if (all.empty())
+    {
+        std::cerr << "taskmasterctl: no command completed\n";
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all] (double p) {
+        return all[std::min(all.size() - 1, (size_t)(p * all.size()))];
+    };
+    std::cout << "clients:      " << clients << "\n"
+              << "commands:     " << all.size() << " (" << failures << " failed)\n"
+              << "elapsed:      " << elapsed << "s\n"
+              << "commands/sec: " << (size_t)(all.size() / elapsed) << "\n"
+              << "latency p50:  " << percentile(0.50) << "us\n"
+              << "latency p99:  " << percentile(0.99) << "us\n"
+              << "latency max:  " << all.back() << "us\n";
+    return failures ? 1 : 0;
+}
+
+/*
+** read the status table straight from shared memory, taskmaster isn't involved
+*/
+static auto PrintStatusTable(const string & name) -> int
+{
+    StatusTable table;
+    StatusTable::EntryData entry;
+    std::time_t now = std::time(nullptr);
+
+    if (table.open(name) == -1)
+    {
+        std::cerr << "taskmasterctl: " << name << ": " << std::strerror(errno) << "\n";
+        return 2;
+    }
+    std::cout << std::left
+              << std::setw(24) << "NAME" << std::setw(10) << "STATE" << std::setw(9) << "PID"
+              << std::setw(10) << "UPTIME" << std::setw(10) << "RESTARTS" << std::setw(6) << "EXIT"
+              << std::setw(10) << "CPU(ms)" << "MAXRSS(kB)\n";
+    for (uint32_t slot = 0; slot < table.getHighWater(); ++slot)
+    {
+        if (!table.read(slot, entry))
+        {
+            continue;
+        }
+        bool is_up = entry.state == ProcessState::Running || entry.state == ProcessState::Ready ||
+            entry.state == ProcessState::Spare;
+        string exit_code = (entry.lastSignal) ?
+            "SIG" + std::to_string(entry.lastSignal) :
+            std::to_string(entry.lastExitCode);
+        std::cout << std::setw(24) << entry.name
+                  << std::setw(10) << ProcessStateName(entry.state)
+                  << std::setw(9) << ((is_up) ? std::to_string(entry.pid) : "-")
+                  << std::setw(10) << ((is_up) ? std::to_string(now - entry.startTime) + "s" : "-")
+                  << std::setw(10) << entry.restarts
+                  << std::setw(6) << exit_code
+                  << std::setw(10) << (entry.userTimeUs + entry.systemTimeUs) / 1000
+                  << entry.maxRssKb << "\n";
+    }
+    return 0;
+}
+
+static auto JoinArguments(int ac, char **av, int from) -> string
+{
+    string out;
+
+    for (int i = from; i < ac; ++i)
+    {
+        if (!out.empty())
+        {
+            out += " ";
+        }
+        out += av[i];
+    }
+    return out;
+}
+};
+
+int main(int ac, char **av)
+{
+    string socket_path = DefaultSocketPath;
+    int i = 1;
+
+    if (i < ac && !std::strcmp(av[i], "--help"))
+    {return PrintUsage();}
+    if (i + 1 < ac && !std::strcmp(av[i], "--status-shm"))
+    {return PrintStatusTable(av[i + 1]);}
+    if (i + 1 < ac && !std::strcmp(av[i], "--socket"))
+    {
+        socket_path = av[i + 1];
+        i += 2;
+    }
+    if (i < ac && !std::strcmp(av[i], "--bench"))
+    {
+        if (i + 2 >= ac)
+        {return PrintUsage();}
+        int clients = std::atoi(av[i + 1]);
+        int requests = std::atoi(av[i + 2]);
+        string command = JoinArguments(ac, av, i + 3);
+        if (clients <= 0 || requests <= 0)
+        {return PrintUsage();}
+        return Bench(socket_path, clients, requests, command.empty() ? "status" : command);
+    }
+
+    int fd = ControlProtocol::Connect(socket_path);
+    if (fd == -1)
+    {
+        std::cerr << "taskmasterctl: " << socket_path << ": " << std::strerror(errno) << "\n";
+        return 2;
+    }
+    string buffer;
+    int ret = 0;
+    if (i < ac)
+    {
+        ret = Execute(fd, buffer, JoinArguments(ac, av, i));
+    }
+    else
+    {
+        string line;
+        while (ret != 2 && std::getline(std::cin, line))
+        {
+            if (!line.empty())
+            {
+                ret = Execute(fd, buffer, line);
+            }
+        }
+    }
+    ::close(fd);
+    return ret;
+}
@@ -0,0 +1,10 @@
+# sourced by the test scripts at the root of the repo
+
+# check <got> <expected> <description>
+check() {
+    if [ "$1" = "$2" ]; then
+        echo -e "\033[32m PASS: $3 \033[0m"
+    else
+        echo -e "\033[31m FAIL: $3 (got: $1) \033[0m"
+    fi
+}